@@ -28,13 +28,8 @@ set (UCD_GEN_INCLUDE_DIR ${CMAKE_CURRENT_BINARY_DIR}/generated/include)
 set (UCD_GEN_OUTPUT_DIR ${UCD_GEN_INCLUDE_DIR}/char_db/generated)
 set (UCD_GEN_INTERMEDIATE_DIR ${CMAKE_CURRENT_BINARY_DIR}/ucd)
 set (UCD_GEN_OUTPUT_FILES
-    ${UCD_GEN_OUTPUT_DIR}/bmp_ranges.inc
-    ${UCD_GEN_OUTPUT_DIR}/non_bmp_ranges.inc
-    ${UCD_GEN_OUTPUT_DIR}/utf8_ranges_1.inc
-    ${UCD_GEN_OUTPUT_DIR}/utf8_ranges_2.inc
-    ${UCD_GEN_OUTPUT_DIR}/utf8_ranges_3.inc
-    ${UCD_GEN_OUTPUT_DIR}/utf8_ranges_4.inc
-    ${UCD_GEN_OUTPUT_DIR}/just_ranges.inc
+    ${UCD_GEN_OUTPUT_DIR}/assigned_stage1.inc
+    ${UCD_GEN_OUTPUT_DIR}/assigned_stage2.inc
 )
 
 add_custom_command (
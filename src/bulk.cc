@@ -0,0 +1,1059 @@
+export module vspefs.char_db : bulk;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wimport-implementation-partition-unit-in-interface-unit"
+  import : simd;
+  import : ucd;
+#pragma clang diagnostic pop
+
+import : database;
+import std;
+
+
+// results
+namespace char_db {
+
+export enum class transcode_status : std::uint8_t
+{
+  ok,
+  invalid_input,
+  output_exhausted,
+};
+
+// Much like std::to_chars_result: read and written cover the characters
+// converted before stopping, so on failure input[read] is where the
+// offending character (or the one that did not fit) begins.
+export struct transcode_result
+{
+  std::size_t read;
+  std::size_t written;
+  transcode_status status;
+};
+
+} // namespace char_db
+
+
+// transcoding
+namespace char_db {
+
+export template <typename From, typename To>
+requires database_of<From, typename From::char_type> && database_of<To, typename To::char_type>
+  constexpr transcode_result transcode (std::span<typename From::char_type const>,
+                                        std::span<typename To::char_type>) noexcept;
+
+// Like transcode<From, To> (), but writes U+FFFD for every ill-formed
+// sequence and every character one side refuses, so the status is never
+// invalid_input. An ill-formed sequence is replaced one maximal subpart at
+// a time, as Unicode recommends. transcode_replacing<Db, Db> () gives a
+// copy of the input with its invalid characters replaced.
+export template <typename From, typename To>
+requires database_of<From, typename From::char_type> && database_of<To, typename To::char_type>
+  constexpr transcode_result transcode_replacing (std::span<typename From::char_type const>,
+                                                  std::span<typename To::char_type>) noexcept;
+
+// decode_into<Db> () and encode_from<Db> () convert between Db and UTF-32
+// with the same rules about unassigned code points as Db.
+export template <typename Db>
+requires database_of<Db, typename Db::char_type>
+  constexpr transcode_result decode_into (std::span<typename Db::char_type const>,
+                                          std::span<char32_t>) noexcept;
+
+export template <typename Db>
+requires database_of<Db, typename Db::char_type>
+  constexpr transcode_result encode_from (std::span<char32_t const>,
+                                          std::span<typename Db::char_type>) noexcept;
+
+// The number of To units transcode<From, To> () writes for input given
+// enough room: like char_size (), it counts up to the first invalid
+// character.
+export template <typename From, typename To>
+requires database_of<From, typename From::char_type> && database_of<To, typename To::char_type>
+  constexpr std::size_t required_length (std::span<typename From::char_type const>) noexcept;
+
+// A resizable contiguous container of CharT, such as std::basic_string or
+// std::vector.
+export template <typename B, typename CharT>
+  concept output_buffer = std::same_as<typename B::value_type, CharT>
+                          && requires (B &buffer, std::size_t const size)
+  {
+    buffer.resize (size);
+    { buffer.data () } -> std::same_as<CharT *>;
+    { buffer.size () } -> std::convertible_to<std::size_t>;
+  };
+
+// Appends input encoded in Db to buffer. The output size of the whole
+// input is measured first, so buffer grows once and the code points are
+// then written without checking them again. On invalid_input, the code
+// points before the offending one are appended.
+export template <typename Db, typename OutputBuffer>
+requires database_of<Db, typename Db::char_type> && output_buffer<OutputBuffer, typename Db::char_type>
+  constexpr transcode_result encode_all (std::span<char32_t const>, OutputBuffer &);
+
+template <typename Db>
+  concept utf8_database = std::same_as<Db, utf8> || std::same_as<Db, utf8_wellformed>;
+
+template <typename Db>
+  concept utf16_database = std::same_as<Db, utf16> || std::same_as<Db, utf16_wellformed>;
+
+template <typename Db>
+  concept utf32_database = std::same_as<Db, utf32> || std::same_as<Db, utf32_wellformed>;
+
+template <typename Db>
+  concept utf_database = utf8_database<Db> || utf16_database<Db> || utf32_database<Db>;
+
+// The database a byte-ordered one stores the units of, or Db itself.
+template <typename Db>
+  struct native_database_of
+  {
+    using type = Db;
+  };
+
+template <typename Db, std::endian Order>
+  struct native_database_of<byte_ordered<Db, Order>>
+  {
+    using type = Db;
+  };
+
+template <typename Db>
+  using native_database_t = typename native_database_of<Db>::type;
+
+template <typename Db>
+  concept byte_ordered_database = !std::same_as<Db, native_database_t<Db>>;
+
+// UTF databases in any byte order, which the bulk paths all take.
+template <typename Db>
+  concept bulk_database = utf_database<native_database_t<Db>>;
+
+// Whether Db refuses unassigned code points, which the bulk kernels leave
+// to a separate check.
+template <typename Db>
+  inline constexpr bool checks_assigned = std::same_as<native_database_t<Db>, utf8>
+                                          || std::same_as<native_database_t<Db>, utf16>
+                                          || std::same_as<native_database_t<Db>, utf32>;
+
+template <typename Db>
+  using utf32_counterpart = std::conditional_t<checks_assigned<Db>, utf32, utf32_wellformed>;
+
+// The databases of each encoding, by code unit type.
+template <typename CharT>
+  struct utf_databases;
+
+template <>
+  struct utf_databases<char8_t>
+  {
+    using checked = utf8;
+    using wellformed = utf8_wellformed;
+  };
+
+template <>
+  struct utf_databases<char16_t>
+  {
+    using checked = utf16;
+    using wellformed = utf16_wellformed;
+  };
+
+template <>
+  struct utf_databases<char32_t>
+  {
+    using checked = utf32;
+    using wellformed = utf32_wellformed;
+  };
+
+// Whether seq, shorter than the longest character of Db, may still become
+// a character with more units.
+template <typename Db>
+  constexpr bool
+  is_char_prefix (std::span<typename Db::char_type const> const seq) noexcept
+  {
+    if constexpr (utf8_database<Db>)
+      {
+        char8_t const lead = seq[0];
+        char8_t lower = 0x80, upper = 0xBF;
+        std::size_t mblen = 0;
+
+        if (0xC2 <= lead && lead <= 0xDF)
+          mblen = 2;
+        else if (0xE0 <= lead && lead <= 0xEF)
+          {
+            mblen = 3;
+            lower = 0xE0 == lead ? 0xA0 : 0x80;
+            upper = 0xED == lead ? 0x9F : 0xBF;
+          }
+        else if (0xF0 <= lead && lead <= 0xF4)
+          {
+            mblen = 4;
+            lower = 0xF0 == lead ? 0x90 : 0x80;
+            upper = 0xF4 == lead ? 0x8F : 0xBF;
+          }
+        else
+          return false;
+
+        if (mblen <= seq.size ())
+          return false;
+        if (2 <= seq.size () && (seq[1] < lower || upper < seq[1]))
+          return false;
+
+        return std::ranges::all_of (seq.subspan (std::min<std::size_t> (2, seq.size ())),
+                                    utf8::is_continuation_unit);
+      }
+    else if constexpr (utf16_database<Db>)
+      return 1 == seq.size () && utf16::is_high_surrogate (seq[0]);
+    else if constexpr (byte_ordered_database<Db>)
+      {
+        std::array<typename Db::char_type, Db::max_mblen> units;
+        auto const length = Db::to_native (seq, units);
+        return is_char_prefix<native_database_t<Db>> (std::span<typename Db::char_type const> (units.data (), length));
+      }
+    else
+      return false;
+  }
+
+// How many units of seq, which does not begin with a valid character of
+// Db, one U+FFFD stands for. A well-formed character that is unassigned
+// is replaced whole. Otherwise this is the maximal subpart, the longest
+// start of a well-formed sequence, or a single unit, as Unicode
+// recommends in section 3.9 ("U+FFFD Substitution of Maximal Subparts").
+template <typename Db>
+  constexpr std::size_t
+  replaced_length (std::span<typename Db::char_type const> const seq) noexcept
+  {
+    if constexpr (utf_database<Db>)
+      {
+        using wellformed = typename utf_databases<typename Db::char_type>::wellformed;
+
+        if (auto const mblen = wellformed::front_mblen (seq);
+            0 != mblen)
+          return mblen;
+
+        for (auto length = std::min (seq.size (), Db::max_mblen - 1); 1 < length; --length)
+          if (is_char_prefix<Db> (seq.first (length)))
+            return length;
+      }
+    else if constexpr (byte_ordered_database<Db>)
+      {
+        std::array<typename Db::char_type, Db::max_mblen> units;
+        auto const length = Db::to_native (seq.first (std::min (seq.size (), units.size ())), units);
+        return replaced_length<native_database_t<Db>> (std::span<typename Db::char_type const> (units.data (), length));
+      }
+
+    return 1;
+  }
+
+// The reference algorithm, one character at a time, up to the first
+// character beginning at or past limit. With Replace, what is not a valid
+// character is written as U+FFFD and only running out of output stops it.
+template <typename From, typename To, bool Replace = false>
+  constexpr void
+  transcode_scalar (std::span<typename From::char_type const> const input,
+                    std::span<typename To::char_type> const output,
+                    transcode_result &result,
+                    std::size_t const limit) noexcept
+  {
+    using char_type = typename From::char_type;
+
+    while (result.read < limit)
+      {
+        auto [mblen, code_point] = [&]
+          {
+            if constexpr (requires { From::max_mblen; })
+              if (input.size () - result.read >= From::max_mblen)
+                return From::decode_front (std::span<char_type const, From::max_mblen> (
+                    input.data () + result.read, From::max_mblen));
+
+            return From::decode_front (input.subspan (result.read));
+          } ();
+
+        if (0 == mblen)
+          {
+            if constexpr (!Replace)
+              {
+                result.status = transcode_status::invalid_input;
+                return;
+              }
+
+            mblen = replaced_length<From> (input.subspan (result.read));
+            code_point = ucd::replacement_character;
+          }
+
+        auto size = To::code_unit_size (code_point);
+        if (0 == size)
+          {
+            if constexpr (!Replace)
+              {
+                result.status = transcode_status::invalid_input;
+                return;
+              }
+
+            code_point = ucd::replacement_character;
+            size = To::code_unit_size (code_point);
+          }
+
+        if (output.size () - result.written < size)
+          {
+            result.status = transcode_status::output_exhausted;
+            return;
+          }
+
+        To::code_point_on (code_point, output.subspan (result.written, size));
+        result.read += mblen;
+        result.written += size;
+      }
+  }
+
+template <typename From, typename To>
+  constexpr void
+  required_length_scalar (std::span<typename From::char_type const> const input,
+                          transcode_result &result,
+                          std::size_t const limit) noexcept
+  {
+    while (result.read < limit)
+      {
+        auto const [mblen, code_point] = From::decode_front (input.subspan (result.read));
+        auto const size = 0 != mblen ? To::code_unit_size (code_point) : 0;
+        if (0 == size)
+          {
+            result.status = transcode_status::invalid_input;
+            return;
+          }
+
+        result.read += mblen;
+        result.written += size;
+      }
+  }
+
+// The chunked fast path: input is cut in chunks ending on character
+// boundaries, small enough to stay in cache between the passes. A chunk
+// that passes the structure check (and the assigned check, if either side
+// wants it) is converted by a vector kernel; otherwise the scalar
+// algorithm takes over for that chunk and stops exactly where it finds
+// the error.
+//
+// source_traits<CharT> tells how to cut and check chunks of CharT, and
+// convert () overloads do the conversion for every pair of code unit
+// types with a nonzero expansion, the most output units one input unit
+// can give.
+inline constexpr std::size_t chunk_size = 4096;
+
+template <typename CharT>
+  struct source_traits;
+
+template <typename FromChar, typename ToChar>
+  inline constexpr std::size_t expansion = 0;
+
+template <>
+  struct source_traits<char8_t>
+  {
+    // A chunk ends before the lead of the character in[length] belongs
+    // to. Four continuation units in a row belong to no character begun
+    // before them, so length stands if the lead is not among the three
+    // units before in[length].
+    static std::size_t
+    boundary (std::span<char8_t const> const in, std::size_t const length) noexcept
+    {
+      if (length < in.size ())
+        for (std::size_t back = 0; back < utf8::max_mblen && back < length; ++back)
+          if (!utf8::is_continuation_unit (in[length - back]))
+            return length - back;
+      return length;
+    }
+
+    static bool
+    well_formed (std::span<char8_t const> const chunk) noexcept
+    {
+      return simd::utf8_structure::ill_formed
+             != simd::check_utf8_structure (chunk.data (), chunk.data () + chunk.size ());
+    }
+
+    // UTF-8 is the one source not worth decoding twice, so after a
+    // conversion the check goes through what it was converted into.
+    template <typename ToChar>
+      static bool
+      assigned (std::span<char8_t const> const chunk, std::span<ToChar const> const converted) noexcept
+      {
+        if constexpr (std::same_as<ToChar, char8_t>)
+          return assigned (chunk);
+        else
+          return simd::ascii_prefix_length (chunk.data (), chunk.data () + chunk.size ()) == chunk.size ()
+                 || ucd::all_assigned (converted);
+      }
+
+    static bool
+    assigned (std::span<char8_t const> const chunk) noexcept
+    {
+      std::array<char32_t, chunk_size> code_points;
+      auto const first = chunk.data (), last = chunk.data () + chunk.size ();
+
+      if (simd::ascii_prefix_length (first, last) == chunk.size ())
+        return true;
+      return ucd::all_assigned (std::span<char32_t const> (code_points.data (),
+                                                      simd::utf8_to_utf32 (first, last, code_points.data ())));
+    }
+  };
+
+template <>
+  struct source_traits<char16_t>
+  {
+    static std::size_t
+    boundary (std::span<char16_t const> const in, std::size_t const length) noexcept
+    {
+      if (0 != length && length < in.size () && utf16::is_high_surrogate (in[length - 1]))
+        return length - 1;
+      return length;
+    }
+
+    static bool
+    well_formed (std::span<char16_t const> const chunk) noexcept
+    {
+      return simd::utf16_structure::ill_formed
+             != simd::check_utf16_structure (chunk.data (), chunk.data () + chunk.size ());
+    }
+
+    static bool
+    assigned (std::span<char16_t const> const chunk) noexcept
+    {
+      return ucd::all_assigned (chunk);
+    }
+
+    template <typename ToChar>
+      static bool
+      assigned (std::span<char16_t const> const chunk, std::span<ToChar const>) noexcept
+      {
+        return ucd::all_assigned (chunk);
+      }
+  };
+
+template <>
+  struct source_traits<char32_t>
+  {
+    static std::size_t
+    boundary (std::span<char32_t const>, std::size_t const length) noexcept
+    {
+      return length;
+    }
+
+    static bool
+    well_formed (std::span<char32_t const> const chunk) noexcept
+    {
+      return simd::scalar_value_prefix_length (chunk.data (), chunk.data () + chunk.size ()) == chunk.size ();
+    }
+
+    static bool
+    assigned (std::span<char32_t const> const chunk) noexcept
+    {
+      return simd::assigned_prefix_length (chunk.data (), chunk.data () + chunk.size ()) == chunk.size ();
+    }
+
+    template <typename ToChar>
+      static bool
+      assigned (std::span<char32_t const> const chunk, std::span<ToChar const>) noexcept
+      {
+        return assigned (chunk);
+      }
+  };
+
+template <>
+  inline constexpr std::size_t expansion<char8_t, char16_t> = 1;
+template <>
+  inline constexpr std::size_t expansion<char8_t, char32_t> = 1;
+template <>
+  inline constexpr std::size_t expansion<char16_t, char8_t> = 3;
+template <>
+  inline constexpr std::size_t expansion<char16_t, char32_t> = 1;
+template <>
+  inline constexpr std::size_t expansion<char32_t, char8_t> = 4;
+template <>
+  inline constexpr std::size_t expansion<char32_t, char16_t> = 2;
+
+// Within one encoding, a clean chunk is copied as it is.
+template <typename CharT>
+  inline constexpr std::size_t expansion<CharT, CharT> = 1;
+
+template <typename CharT>
+  std::size_t
+  convert (std::span<CharT const> const chunk, CharT *const out) noexcept
+  {
+    std::ranges::copy (chunk, out);
+    return chunk.size ();
+  }
+
+template <typename CharT>
+  std::size_t
+  converted_length (std::span<CharT const> const chunk, std::type_identity<CharT>) noexcept
+  {
+    return chunk.size ();
+  }
+
+std::size_t
+convert (std::span<char8_t const> const chunk, char16_t *const out) noexcept
+{
+  return simd::utf8_to_utf16 (chunk.data (), chunk.data () + chunk.size (), out);
+}
+
+std::size_t
+convert (std::span<char8_t const> const chunk, char32_t *const out) noexcept
+{
+  return simd::utf8_to_utf32 (chunk.data (), chunk.data () + chunk.size (), out);
+}
+
+std::size_t
+convert (std::span<char16_t const> const chunk, char8_t *const out) noexcept
+{
+  return simd::utf16_to_utf8 (chunk.data (), chunk.data () + chunk.size (), out);
+}
+
+std::size_t
+convert (std::span<char16_t const> const chunk, char32_t *const out) noexcept
+{
+  return simd::utf16_to_utf32 (chunk.data (), chunk.data () + chunk.size (), out);
+}
+
+std::size_t
+convert (std::span<char32_t const> const chunk, char8_t *const out) noexcept
+{
+  return simd::utf32_to_utf8 (chunk.data (), chunk.data () + chunk.size (), out);
+}
+
+std::size_t
+convert (std::span<char32_t const> const chunk, char16_t *const out) noexcept
+{
+  return simd::utf32_to_utf16 (chunk.data (), chunk.data () + chunk.size (), out);
+}
+
+std::size_t
+converted_length (std::span<char8_t const> const chunk, std::type_identity<char16_t>) noexcept
+{
+  return simd::utf8_to_utf16_length (chunk.data (), chunk.data () + chunk.size ());
+}
+
+std::size_t
+converted_length (std::span<char8_t const> const chunk, std::type_identity<char32_t>) noexcept
+{
+  return simd::utf8_to_utf32_length (chunk.data (), chunk.data () + chunk.size ());
+}
+
+std::size_t
+converted_length (std::span<char16_t const> const chunk, std::type_identity<char8_t>) noexcept
+{
+  return simd::utf16_to_utf8_length (chunk.data (), chunk.data () + chunk.size ());
+}
+
+std::size_t
+converted_length (std::span<char16_t const> const chunk, std::type_identity<char32_t>) noexcept
+{
+  return simd::utf16_to_utf32_length (chunk.data (), chunk.data () + chunk.size ());
+}
+
+std::size_t
+converted_length (std::span<char32_t const> const chunk, std::type_identity<char8_t>) noexcept
+{
+  return simd::utf32_to_utf8_length (chunk.data (), chunk.data () + chunk.size ());
+}
+
+std::size_t
+converted_length (std::span<char32_t const> const chunk, std::type_identity<char16_t>) noexcept
+{
+  return simd::utf32_to_utf16_length (chunk.data (), chunk.data () + chunk.size ());
+}
+
+template <typename From, typename To, bool Replace = false>
+  void
+  transcode_chunks (std::span<typename From::char_type const> const input,
+                    std::span<typename To::char_type> const output,
+                    transcode_result &result) noexcept
+  {
+    using from_type = typename From::char_type;
+    using to_type = typename To::char_type;
+    using source = source_traits<from_type>;
+
+    while (transcode_status::ok == result.status && result.read < input.size ())
+      {
+        auto const in = input.subspan (result.read);
+        auto const out = output.subspan (result.written);
+
+        auto const length = source::boundary (in, std::min ({ chunk_size,
+                                                               in.size (),
+                                                               out.size () / expansion<from_type, to_type> }));
+        if (0 == length)
+          return;
+
+        auto const chunk = in.first (length);
+        if (!source::well_formed (chunk))
+          {
+            transcode_scalar<From, To, Replace> (input, output, result, result.read + length);
+            continue;
+          }
+
+        auto const written = convert (chunk, out.data ());
+        if constexpr (checks_assigned<From> || checks_assigned<To>)
+          if (!source::assigned (chunk, std::span<to_type const> (out.first (written))))
+            {
+              transcode_scalar<From, To, Replace> (input, output, result, result.read + length);
+              continue;
+            }
+
+        result.read += length;
+        result.written += written;
+      }
+  }
+
+template <typename From, typename To>
+  void
+  required_length_chunks (std::span<typename From::char_type const> const input,
+                          transcode_result &result) noexcept
+  {
+    using from_type = typename From::char_type;
+    using source = source_traits<from_type>;
+
+    while (transcode_status::ok == result.status && result.read < input.size ())
+      {
+        auto const in = input.subspan (result.read);
+        auto const length = source::boundary (in, std::min (chunk_size, in.size ()));
+        if (0 == length)
+          return;
+
+        auto const chunk = in.first (length);
+        bool clean = source::well_formed (chunk);
+        if constexpr (checks_assigned<From> || checks_assigned<To>)
+          clean = clean && source::assigned (chunk);
+
+        if (!clean)
+          {
+            required_length_scalar<From, To> (input, result, result.read + length);
+            continue;
+          }
+
+        result.read += length;
+        result.written += converted_length (chunk, std::type_identity<typename To::char_type> ());
+      }
+  }
+
+// Out-of-line entry points for the chunked path, one per pair of code
+// unit types, so that it is compiled once into the library rather than in
+// every user of transcode () and required_length (). Whether unassigned
+// code points are refused is all that tells the databases of one encoding
+// apart here, so it is passed as check_assigned; replace picks
+// transcode_replacing () over transcode (). required_length_contiguous ()
+// also tells how much of the input it measured.
+template <typename From, typename To, bool Replace>
+  transcode_result
+  transcode_bulk (std::span<typename From::char_type const> const input,
+                  std::span<typename To::char_type> const output) noexcept
+  {
+    auto result = transcode_result { 0, 0, transcode_status::ok };
+
+    transcode_chunks<From, To, Replace> (input, output, result);
+    if (transcode_status::ok == result.status)
+      transcode_scalar<From, To, Replace> (input, output, result, input.size ());
+
+    return result;
+  }
+
+template <typename From, typename To>
+  transcode_result
+  required_length_bulk (std::span<typename From::char_type const> const input) noexcept
+  {
+    auto result = transcode_result { 0, 0, transcode_status::ok };
+
+    required_length_chunks<From, To> (input, result);
+    if (transcode_status::ok == result.status)
+      required_length_scalar<From, To> (input, result, input.size ());
+
+    return result;
+  }
+
+template <typename FromChar, typename ToChar, bool Replace>
+  transcode_result
+  transcode_contiguous_impl (std::span<FromChar const> const input, std::span<ToChar> const output,
+                             bool const check_assigned) noexcept
+  {
+    if (check_assigned)
+      return transcode_bulk<typename utf_databases<FromChar>::checked,
+                            typename utf_databases<ToChar>::checked, Replace> (input, output);
+    else
+      return transcode_bulk<typename utf_databases<FromChar>::wellformed,
+                            typename utf_databases<ToChar>::wellformed, Replace> (input, output);
+  }
+
+template <typename FromChar, typename ToChar>
+  transcode_result
+  transcode_contiguous_impl (std::span<FromChar const> const input, std::span<ToChar> const output,
+                             bool const check_assigned, bool const replace) noexcept
+  {
+    if (replace)
+      return transcode_contiguous_impl<FromChar, ToChar, true> (input, output, check_assigned);
+    else
+      return transcode_contiguous_impl<FromChar, ToChar, false> (input, output, check_assigned);
+  }
+
+template <typename FromChar, typename ToChar>
+  transcode_result
+  required_length_contiguous_impl (std::span<FromChar const> const input, std::type_identity<ToChar>,
+                                   bool const check_assigned) noexcept
+  {
+    if (check_assigned)
+      return required_length_bulk<typename utf_databases<FromChar>::checked,
+                                  typename utf_databases<ToChar>::checked> (input);
+    else
+      return required_length_bulk<typename utf_databases<FromChar>::wellformed,
+                                  typename utf_databases<ToChar>::wellformed> (input);
+  }
+
+transcode_result
+transcode_contiguous (std::span<char8_t const> const input, std::span<char8_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char8_t const> const input, std::span<char16_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char8_t const> const input, std::span<char32_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char16_t const> const input, std::span<char8_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char16_t const> const input, std::span<char16_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char16_t const> const input, std::span<char32_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char32_t const> const input, std::span<char8_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char32_t const> const input, std::span<char16_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+transcode_contiguous (std::span<char32_t const> const input, std::span<char32_t> const output,
+                      bool const check_assigned, bool const replace) noexcept
+{
+  return transcode_contiguous_impl (input, output, check_assigned, replace);
+}
+
+transcode_result
+required_length_contiguous (std::span<char8_t const> const input, std::type_identity<char8_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char8_t const> const input, std::type_identity<char16_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char8_t const> const input, std::type_identity<char32_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char16_t const> const input, std::type_identity<char8_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char16_t const> const input, std::type_identity<char16_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char16_t const> const input, std::type_identity<char32_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char32_t const> const input, std::type_identity<char8_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char32_t const> const input, std::type_identity<char16_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+transcode_result
+required_length_contiguous (std::span<char32_t const> const input, std::type_identity<char32_t> const to,
+                            bool const check_assigned) noexcept
+{
+  return required_length_contiguous_impl (input, to, check_assigned);
+}
+
+// The entry points above for databases in any byte order. Byte-ordered
+// input is brought to the native order a chunk at a time, in a buffer
+// that stays in cache. Otherwise input is still taken a chunk at a time
+// when the output is byte-ordered, so that the output of each chunk is
+// swapped in place while it is still in cache; there is no pass over the
+// whole buffer.
+template <typename From, typename To, bool Replace>
+  transcode_result
+  transcode_ordered (std::span<typename From::char_type const> const input,
+                     std::span<typename To::char_type> const output) noexcept
+  {
+    using from_type = typename From::char_type;
+
+    bool const check_assigned = checks_assigned<From> || checks_assigned<To>;
+    if constexpr (!byte_ordered_database<From> && !byte_ordered_database<To>)
+      return transcode_contiguous (input, output, check_assigned, Replace);
+    else
+      {
+        auto result = transcode_result { 0, 0, transcode_status::ok };
+        std::array<from_type, chunk_size> native;
+
+        while (transcode_status::ok == result.status && result.read < input.size ())
+          {
+            auto in = input.subspan (result.read);
+            if constexpr (byte_ordered_database<From>)
+              in = std::span<from_type const> (native.data (), From::to_native (in, native));
+            else
+              in = in.first (source_traits<from_type>::boundary (in, std::min (chunk_size, in.size ())));
+
+            auto const out = output.subspan (result.written);
+            auto const converted = transcode_contiguous (in, out, check_assigned, Replace);
+            if constexpr (byte_ordered_database<To>)
+              for (auto &unit : out.first (converted.written))
+                unit = To::to_native (unit);
+
+            result.read += converted.read;
+            result.written += converted.written;
+            result.status = converted.status;
+          }
+
+        return result;
+      }
+  }
+
+template <typename From, typename To>
+  transcode_result
+  required_length_ordered (std::span<typename From::char_type const> const input) noexcept
+  {
+    using from_type = typename From::char_type;
+    using to_type = typename To::char_type;
+
+    bool const check_assigned = checks_assigned<From> || checks_assigned<To>;
+    if constexpr (!byte_ordered_database<From>)
+      return required_length_contiguous (input, std::type_identity<to_type> (), check_assigned);
+    else
+      {
+        auto result = transcode_result { 0, 0, transcode_status::ok };
+        std::array<from_type, chunk_size> native;
+
+        while (transcode_status::ok == result.status && result.read < input.size ())
+          {
+            auto const length = From::to_native (input.subspan (result.read), native);
+            auto const measured = required_length_contiguous (std::span<from_type const> (native.data (), length),
+                                                              std::type_identity<to_type> (), check_assigned);
+
+            result.read += measured.read;
+            result.written += measured.written;
+            result.status = measured.status;
+          }
+
+        return result;
+      }
+  }
+
+template <typename From, typename To>
+requires database_of<From, typename From::char_type> && database_of<To, typename To::char_type>
+  constexpr transcode_result
+  transcode (std::span<typename From::char_type const> const input,
+             std::span<typename To::char_type> const output) noexcept
+  {
+    if !consteval
+      {
+        if constexpr (bulk_database<From> && bulk_database<To>
+                      && 0 != expansion<typename From::char_type, typename To::char_type>)
+          return transcode_ordered<From, To, false> (input, output);
+      }
+
+    auto result = transcode_result { 0, 0, transcode_status::ok };
+    transcode_scalar<From, To> (input, output, result, input.size ());
+    return result;
+  }
+
+template <typename From, typename To>
+requires database_of<From, typename From::char_type> && database_of<To, typename To::char_type>
+  constexpr transcode_result
+  transcode_replacing (std::span<typename From::char_type const> const input,
+                       std::span<typename To::char_type> const output) noexcept
+  {
+    if !consteval
+      {
+        if constexpr (bulk_database<From> && bulk_database<To>
+                      && 0 != expansion<typename From::char_type, typename To::char_type>)
+          return transcode_ordered<From, To, true> (input, output);
+      }
+
+    auto result = transcode_result { 0, 0, transcode_status::ok };
+    transcode_scalar<From, To, true> (input, output, result, input.size ());
+    return result;
+  }
+
+// required_length () with the input it covers as read, and invalid_input
+// if that is not all of it.
+template <typename From, typename To>
+  constexpr transcode_result
+  measure (std::span<typename From::char_type const> const input) noexcept
+  {
+    if !consteval
+      {
+        if constexpr (bulk_database<From> && bulk_database<To>
+                      && 0 != expansion<typename From::char_type, typename To::char_type>)
+          return required_length_ordered<From, To> (input);
+      }
+
+    auto result = transcode_result { 0, 0, transcode_status::ok };
+    required_length_scalar<From, To> (input, result, input.size ());
+    return result;
+  }
+
+template <typename From, typename To>
+requires database_of<From, typename From::char_type> && database_of<To, typename To::char_type>
+  constexpr std::size_t
+  required_length (std::span<typename From::char_type const> const input) noexcept
+  {
+    return measure<From, To> (input).written;
+  }
+
+template <typename Db>
+requires database_of<Db, typename Db::char_type>
+  constexpr transcode_result
+  decode_into (std::span<typename Db::char_type const> const input, std::span<char32_t> const output) noexcept
+  {
+    return transcode<Db, utf32_counterpart<Db>> (input, output);
+  }
+
+template <typename Db>
+requires database_of<Db, typename Db::char_type>
+  constexpr transcode_result
+  encode_from (std::span<char32_t const> const input, std::span<typename Db::char_type> const output) noexcept
+  {
+    return transcode<utf32_counterpart<Db>, Db> (input, output);
+  }
+
+// Writes code points measure () has accepted, so the vector kernels take
+// them without further checks and no code point is looked up twice.
+// Byte-ordered output is swapped a chunk at a time as it is written. The
+// kernels store whole vectors past what they write, so as the output has
+// no room to spare, the last code points are written one at a time over
+// that overhang.
+inline constexpr std::size_t encode_tail_length = 16;
+
+template <typename Db>
+  constexpr std::size_t
+  encode_measured (std::span<char32_t const> const input, typename Db::char_type *const out) noexcept
+  {
+    if !consteval
+      {
+        if constexpr (bulk_database<Db>)
+          {
+            auto const to_order = [out] (std::size_t const first, std::size_t const last)
+              {
+                if constexpr (byte_ordered_database<Db>)
+                  for (auto &unit : std::span (out + first, out + last))
+                    unit = Db::to_native (unit);
+              };
+
+            auto const head = input.size () - std::min (input.size (), encode_tail_length);
+            std::size_t written = 0;
+            for (std::size_t offset = 0; offset < head; offset += chunk_size)
+              {
+                auto const converted = convert (input.subspan (offset, std::min (chunk_size, head - offset)),
+                                                out + written);
+                to_order (written, written + converted);
+                written += converted;
+              }
+
+            for (auto const code_point : input.subspan (head))
+              {
+                auto const converted = simd::encode_one (code_point, out + written);
+                to_order (written, written + converted);
+                written += converted;
+              }
+
+            return written;
+          }
+      }
+
+    std::size_t written = 0;
+    for (auto const code_point : input)
+      {
+        auto const size = Db::code_unit_size (code_point);
+        Db::code_point_on (code_point, std::span<typename Db::char_type> (out + written, size));
+        written += size;
+      }
+
+    return written;
+  }
+
+template <typename Db, typename OutputBuffer>
+requires database_of<Db, typename Db::char_type> && output_buffer<OutputBuffer, typename Db::char_type>
+  constexpr transcode_result
+  encode_all (std::span<char32_t const> const input, OutputBuffer &buffer)
+  {
+    using char_type = typename Db::char_type;
+
+    auto const result = measure<utf32_counterpart<Db>, Db> (input);
+    auto const accepted = input.first (result.read);
+    std::size_t const offset = buffer.size ();
+
+    if constexpr (requires { buffer.resize_and_overwrite (offset, [] (char_type *, std::size_t) { return 0; }); })
+      buffer.resize_and_overwrite (offset + result.written, [&] (char_type *const data, std::size_t)
+        {
+          return offset + encode_measured<Db> (accepted, data + offset);
+        });
+    else
+      {
+        buffer.resize (offset + result.written);
+        encode_measured<Db> (accepted, buffer.data () + offset);
+      }
+
+    return result;
+  }
+
+} // namespace char_db
@@ -2,6 +2,11 @@ export module vspefs.char_db;
 
 
 export import : utils;
+export import : ucd;
+export import : dispatch;
+export import : simd;
 export import : containers;
 export import : database;
+export import : bulk;
+export import : stream;
 export import : views;
\ No newline at end of file
@@ -1,5 +1,8 @@
 module;
 #include <climits>
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>
+#endif
 
 export module vspefs.char_db : containers;
 
@@ -8,14 +11,23 @@ import std;
 
 namespace char_db::containers {
 
-template <std::size_t N>
-  class succinct_bitset
+// Rank and select over the words of a succinct bitset, shared by its
+// fixed-size and dynamic specializations, which own the storage.
+//
+// Words are grouped into superblocks of 64. l1_ holds the number of set
+// bits before each superblock, followed by the total, and l2_ the number
+// before each word within its superblock, so a rank is two lookups and a
+// popcount. For select, ones_samples_ and zeros_samples_ hold the
+// superblock every select_sample_rate-th set or clear bit lies in; a
+// select only searches the superblocks between two samples, and then the
+// words of one superblock.
+template <typename Derived>
+  class succinct_bitset_interface
   {
   public:
-    constexpr succinct_bitset () = default;
-    constexpr explicit succinct_bitset (std::from_range_t, utils::container_compatible_range<bool> auto &&);
+    using word_type = std::uintptr_t;
+    static constexpr std::size_t word_size = CHAR_BIT * sizeof (word_type);
 
-    [[nodiscard]] consteval std::size_t size () const noexcept;
     [[nodiscard]] constexpr std::size_t count () const noexcept;
     [[nodiscard]] constexpr bool at (std::size_t) const noexcept;
 
@@ -27,371 +39,353 @@ template <std::size_t N>
     template <bool Value = true>
     [[nodiscard]] constexpr std::size_t select (std::size_t) const noexcept;
 
+  protected:
+    static constexpr std::size_t superblock_words = 64;
+    static constexpr std::size_t superblock_size = superblock_words * word_size;
+    static constexpr std::size_t select_sample_rate = 1024;
+
+    static constexpr std::size_t word_count (std::size_t bits) noexcept;
+    static constexpr std::size_t superblock_count (std::size_t bits) noexcept;
+    static constexpr std::size_t sample_count (std::size_t bits) noexcept;
+
+    // Fills in the directories once the words and the size are in place.
+    constexpr void index () noexcept;
+
+  private:
+    constexpr Derived &derived () noexcept;
+    constexpr Derived const &derived () const noexcept;
+
+    template <bool Value>
+    constexpr std::size_t count_before_superblock (std::size_t) const noexcept;
+    template <bool Value>
+    constexpr std::size_t count_before_word (std::size_t) const noexcept;
+  };
+
+// select_in_byte_table[k << 8 | byte] is the position of the (k+1)th set
+// bit of byte, for the last step of select_in_word.
+inline constexpr auto select_in_byte_table = []
+{
+  std::array<std::uint8_t, 8 * 256> table {};
+  for (std::size_t byte = 0; byte != 256; ++byte)
+    for (std::size_t bit = 0, k = 0; bit != 8; ++bit)
+      if (0 != ((byte >> bit) & 1))
+        table[k++ << 8 | byte] = static_cast<std::uint8_t> (bit);
+  return table;
+} ();
+
+// The position of the (k+1)th set bit of word, which has more than k.
+//
+// With BMI2, pdep deposits a single bit at that position. Otherwise the
+// popcounts of all bytes are summed in one multiplication, the byte the
+// bit lies in is the number of bytes whose running sum is at most k, and
+// a table finishes within that byte.
+template <typename Word>
+  constexpr std::size_t
+  select_in_word (Word const word, std::size_t const k) noexcept
+  {
+    static_assert (64 >= std::numeric_limits<Word>::digits);
+    auto const bits = static_cast<std::uint64_t> (word);
+
+#if defined (__BMI2__) && defined (__x86_64__)
+    if !consteval
+      {
+        return static_cast<std::size_t> (std::countr_zero (_pdep_u64 (std::uint64_t { 1 } << k, bits)));
+      }
+#endif
+
+    constexpr std::uint64_t bytes_low = 0x0101'0101'0101'0101;
+    constexpr std::uint64_t bytes_high = 0x8080'8080'8080'8080;
+
+    auto counts = bits - ((bits >> 1) & 0x5555'5555'5555'5555);
+    counts = (counts & 0x3333'3333'3333'3333) + ((counts >> 2) & 0x3333'3333'3333'3333);
+    counts = (counts + (counts >> 4)) & 0x0F0F'0F0F'0F0F'0F0F;
+
+    // Byte i of sums holds the number of set bits in bytes 0 to i, which
+    // never reaches 0x80, so each byte of the subtraction below keeps its
+    // high bit exactly when k is at least that sum.
+    auto const sums = counts * bytes_low;
+    auto const at_most_k = ((k * bytes_low) | bytes_high) - sums;
+    auto const shift = static_cast<std::size_t> (std::popcount (at_most_k & bytes_high)) * 8;
+    auto const before = static_cast<std::size_t> (((sums << 8) >> shift) & 0xFF);
+
+    return shift + select_in_byte_table[(k - before) << 8 | ((bits >> shift) & 0xFF)];
+  }
+
+template <std::size_t N>
+  class succinct_bitset : public succinct_bitset_interface<succinct_bitset<N>>
+  {
+    using interface = succinct_bitset_interface<succinct_bitset<N>>;
+    friend interface;
+  public:
+    using typename interface::word_type;
+    using interface::word_size;
+
+    constexpr succinct_bitset () = default;
+    constexpr explicit succinct_bitset (std::from_range_t, utils::container_compatible_range<bool> auto &&);
+
+    [[nodiscard]] consteval std::size_t size () const noexcept;
+
   private:
-    using uintword_t = std::uintptr_t;
-    static constexpr std::size_t word_bit_size = CHAR_BIT * sizeof (uintword_t);
-    static constexpr std::size_t l2_bit_size = word_bit_size;
-    static constexpr std::size_t l1_bit_size = 64 * l2_bit_size;
-
-    std::array<uintword_t, (N - 1) / word_bit_size + 1> bits_;
-    std::array<std::size_t, (N - 1) / l1_bit_size + 1> l1_;
-    std::array<std::uint16_t, (N - 1) / l2_bit_size + 1> l2_;
+    static constexpr std::size_t total_bits_ = N;
+
+    std::array<word_type, interface::word_count (N)> bits_ {};
+    std::array<std::size_t, interface::superblock_count (N) + 1> l1_ {};
+    std::array<std::uint16_t, interface::word_count (N)> l2_ {};
+    std::array<std::size_t, interface::sample_count (N)> ones_samples_ {};
+    std::array<std::size_t, interface::sample_count (N)> zeros_samples_ {};
     std::size_t total_set_bits_ = 0;
   };
 
 template <>
   class succinct_bitset<std::dynamic_extent>
+  : public succinct_bitset_interface<succinct_bitset<std::dynamic_extent>>
   {
+    using interface = succinct_bitset_interface<succinct_bitset<std::dynamic_extent>>;
+    friend interface;
   public:
     constexpr succinct_bitset () = default;
     constexpr explicit succinct_bitset (std::from_range_t, utils::container_compatible_range<bool> auto &&);
 
-    [[nodiscard]] constexpr std::size_t size () const noexcept;
-    [[nodiscard]] constexpr std::size_t count () const noexcept;
-    [[nodiscard]] constexpr bool at (std::size_t) const noexcept;
-
-    // Returns the number of bits equal to Value in [0, pos).
-    template <bool Value = true>
-    [[nodiscard]] constexpr std::size_t rank (std::size_t) const noexcept;
+    // Takes size bits already packed into words, bit k being bit
+    // k % word_size of words[k / word_size], with the bits past size clear.
+    constexpr succinct_bitset (std::vector<word_type>, std::size_t size);
 
-    // Returns the position of the (k+1)th bit equal to Value.
-    template <bool Value = true>
-    [[nodiscard]] constexpr std::size_t select (std::size_t) const noexcept;
+    [[nodiscard]] constexpr std::size_t size () const noexcept;
 
   private:
-    using uintword_t = std::uintptr_t;
-    static constexpr std::size_t word_bit_size = CHAR_BIT * sizeof (uintword_t);
-    static constexpr std::size_t l2_bit_size = word_bit_size;
-    static constexpr std::size_t l1_bit_size = 64 * l2_bit_size;
-
     std::size_t total_bits_ = 0;
-    std::vector<uintword_t> bits_;
-    std::vector<std::size_t> l1_;
+    std::vector<word_type> bits_;
+    std::vector<std::size_t> l1_ = { 0 };
     std::vector<std::uint16_t> l2_;
+    std::vector<std::size_t> ones_samples_;
+    std::vector<std::size_t> zeros_samples_;
     std::size_t total_set_bits_ = 0;
   };
 
-template <std::size_t N>
-  constexpr succinct_bitset<N>::succinct_bitset(
-      std::from_range_t, utils::container_compatible_range<bool> auto &&bits)
-  : bits_ (), l1_ (), l2_ ()
+template <typename Derived>
+  constexpr std::size_t
+  succinct_bitset_interface<Derived>::word_count (std::size_t const bits) noexcept
   {
-    std::size_t l1_idx = 0;
-    std::size_t l2_idx = 0;
-    std::size_t l1_sum = 0;
-    std::size_t l2_sum = 0;
-    uintword_t word = 0;
-    std::size_t word_pos = 0;
+    return (bits + word_size - 1) / word_size;
+  }
 
-    for (auto const [index, bit] : bits | utils::views::enumerate)
+template <typename Derived>
+  constexpr std::size_t
+  succinct_bitset_interface<Derived>::superblock_count (std::size_t const bits) noexcept
+  {
+    return (bits + superblock_size - 1) / superblock_size;
+  }
+
+template <typename Derived>
+  constexpr std::size_t
+  succinct_bitset_interface<Derived>::sample_count (std::size_t const bits) noexcept
+  {
+    return (bits + select_sample_rate - 1) / select_sample_rate;
+  }
+
+template <typename Derived>
+  constexpr Derived &
+  succinct_bitset_interface<Derived>::derived () noexcept
+  {
+    return static_cast<Derived &> (*this);
+  }
+
+template <typename Derived>
+  constexpr Derived const &
+  succinct_bitset_interface<Derived>::derived () const noexcept
+  {
+    return static_cast<Derived const &> (*this);
+  }
+
+template <typename Derived>
+  constexpr void
+  succinct_bitset_interface<Derived>::index () noexcept
+  {
+    auto &self = derived ();
+    auto const words = word_count (self.total_bits_);
+    auto const superblocks = superblock_count (self.total_bits_);
+    std::size_t ones = 0;
+
+    for (std::size_t word = 0; word != words; ++word)
       {
-        if (bit)
-          {
-            word |= (static_cast<uintword_t> (1) << (index % word_bit_size));
-            ++l2_sum;
-            ++l1_sum;
-            ++total_set_bits_;
-          }
-        if ((index + 1) % word_bit_size == 0 || index + 1 == N)
-          {
-            bits_[word_pos++] = word;
-            word = 0;
-          }
-        if ((index + 1) % l2_bit_size == 0 || index + 1 == N)
-          {
-            l2_[l2_idx++] = static_cast<std::uint16_t> (l2_sum);
-            l2_sum = 0;
-          }
-        if ((index + 1) % l1_bit_size == 0 || index + 1 == N)
-          {
-            l1_[l1_idx++] = l1_sum;
-            l1_sum = 0;
-          }
+        if (0 == word % superblock_words)
+          self.l1_[word / superblock_words] = ones;
+        self.l2_[word] = static_cast<std::uint16_t> (ones - self.l1_[word / superblock_words]);
+        ones += static_cast<std::size_t> (std::popcount (self.bits_[word]));
       }
-    // Zero-fill any remaining words if input is shorter than N
-    while (word_pos < bits_.size())
+    self.l1_[superblocks] = ones;
+    self.total_set_bits_ = ones;
+
+    auto const zeros = self.total_bits_ - ones;
+    if constexpr (requires { self.ones_samples_.resize (0); })
       {
-        bits_[word_pos++] = word;
-        word = 0;
+        self.ones_samples_.resize (sample_count (ones));
+        self.zeros_samples_.resize (sample_count (zeros));
       }
-    while (l2_idx < l2_.size())
-      l2_[l2_idx++] = 0;
-    while (l1_idx < l1_.size())
-      l1_[l1_idx++] = 0;
-  }
 
-template <std::size_t N>
-  [[nodiscard]] consteval std::size_t
-  succinct_bitset<N>::size () const noexcept
-  {
-    return N;
+    for (std::size_t superblock = 0, one = 0, zero = 0; superblock != superblocks; ++superblock)
+      {
+        auto const ones_until = self.l1_[superblock + 1];
+        auto const zeros_until = std::min ((superblock + 1) * superblock_size, self.total_bits_) - ones_until;
+        for (; one * select_sample_rate < ones_until; ++one)
+          self.ones_samples_[one] = superblock;
+        for (; zero * select_sample_rate < zeros_until; ++zero)
+          self.zeros_samples_[zero] = superblock;
+      }
   }
 
-template <std::size_t N>
+template <typename Derived>
   [[nodiscard]] constexpr std::size_t
-  succinct_bitset<N>::count () const noexcept
+  succinct_bitset_interface<Derived>::count () const noexcept
   {
-    return total_set_bits_;
+    return derived ().total_set_bits_;
   }
 
-template <std::size_t N>
+template <typename Derived>
   constexpr bool
-  succinct_bitset<N>::at(std::size_t pos) const noexcept
+  succinct_bitset_interface<Derived>::at (std::size_t const pos) const noexcept
   {
-    if (pos >= N)
+    if (pos >= derived ().total_bits_)
       return false;
-    std::size_t word_idx = pos / word_bit_size;
-    std::size_t bit_idx = pos % word_bit_size;
-    return (bits_[word_idx] >> bit_idx) & 1;
+    return (derived ().bits_[pos / word_size] >> (pos % word_size)) & 1;
   }
 
-template <std::size_t N>
+template <typename Derived>
   template <bool Value>
-    constexpr std::size_t succinct_bitset<N>::rank(std::size_t pos) const noexcept
+    constexpr std::size_t
+    succinct_bitset_interface<Derived>::count_before_superblock (std::size_t const superblock) const noexcept
     {
-      pos = std::min(pos, N);
-      std::size_t res = 0;
-      std::size_t l1_blocks = pos / l1_bit_size;
-      std::size_t l2_blocks = pos / l2_bit_size;
-      std::size_t word_idx = pos / word_bit_size;
-      std::size_t bit_idx = pos % word_bit_size;
-
+      auto const ones = derived ().l1_[superblock];
       if constexpr (Value)
-        {
-          if (l1_blocks)
-            res += l1_[l1_blocks - 1];
-          if (l2_blocks)
-            res += l2_[l2_blocks - 1];
-          for (std::size_t i = l2_blocks * (l2_bit_size / word_bit_size); i < word_idx; ++i)
-            res += std::popcount(bits_[i]);
-          if (bit_idx)
-            res += std::popcount(bits_[word_idx] & ((static_cast<uintword_t> (1) << bit_idx) - 1));
-          return res;
-        }
+        return ones;
       else
-        {
-          return pos - rank<true>(pos);
-        }
+        return superblock * superblock_size - ones;
     }
 
-template <std::size_t N>
+// Counted from the start of the superblock the word lies in.
+template <typename Derived>
   template <bool Value>
-    constexpr std::size_t succinct_bitset<N>::select(std::size_t k) const noexcept
+    constexpr std::size_t
+    succinct_bitset_interface<Derived>::count_before_word (std::size_t const word) const noexcept
     {
+      std::size_t const ones = derived ().l2_[word];
       if constexpr (Value)
-        {
-          if (k >= total_set_bits_)
-            return N;
-        }
+        return ones;
       else
-        {
-          if (k >= N - total_set_bits_)
-            return N;
-        }
-
-      std::size_t l1_acc = 0, l1_idx = 0;
-      // Find superblock
-      while (l1_idx < l1_.size() &&
-             ((Value ? l1_acc + l1_[l1_idx] : (l1_idx + 1) * l1_bit_size - (l1_acc + l1_[l1_idx])) <= k))
-        {
-          l1_acc += l1_[l1_idx];
-          ++l1_idx;
-        }
-      std::size_t l2_base = l1_idx * (l1_bit_size / l2_bit_size);
-      std::size_t l2_acc = l1_acc, l2_idx = l2_base;
-      // Find block
-      while (l2_idx < l2_.size() &&
-             ((Value ? l2_acc + l2_[l2_idx] : (l2_idx + 1) * l2_bit_size - (l2_acc + l2_[l2_idx])) <= k))
-        {
-          l2_acc += l2_[l2_idx];
-          ++l2_idx;
-        }
-      std::size_t word_base = l2_idx * (l2_bit_size / word_bit_size);
-      std::size_t acc = l2_acc;
-      // Find word
-      std::size_t word_idx = word_base;
-      for (; word_idx < bits_.size(); ++word_idx)
-        {
-          std::size_t pop = Value ? std::popcount(bits_[word_idx]) : word_bit_size - std::popcount(bits_[word_idx]);
-          if (acc + pop > k)
-            break;
-          acc += pop;
-        }
-      // Find bit in word
-      uintword_t w = bits_[word_idx];
-      for (std::size_t b = 0; b < word_bit_size && word_idx * word_bit_size + b < N; ++b)
-        {
-          bool bit = (w >> b) & 1;
-          if (bit == Value)
-            {
-              if (acc == k)
-                return word_idx * word_bit_size + b;
-              ++acc;
-            }
-        }
-      return N;
+        return word % superblock_words * word_size - ones;
     }
 
+template <typename Derived>
+  template <bool Value>
+    constexpr std::size_t
+    succinct_bitset_interface<Derived>::rank (std::size_t const pos) const noexcept
+    {
+      auto const &self = derived ();
+      if (pos >= self.total_bits_)
+        return Value ? self.total_set_bits_ : self.total_bits_ - self.total_set_bits_;
 
+      auto const word = pos / word_size;
+      auto const bit = pos % word_size;
+      auto ones = self.l1_[word / superblock_words] + self.l2_[word];
+      if (0 != bit)
+        ones += static_cast<std::size_t> (std::popcount (self.bits_[word] & ((word_type { 1 } << bit) - 1)));
 
-constexpr succinct_bitset<std::dynamic_extent>::succinct_bitset(
-    std::from_range_t, utils::container_compatible_range<bool> auto &&bits)
-: total_bits_ (std::ranges::size (bits)),
-  bits_ ((total_bits_ - 1) / word_bit_size + 1, 0),
-  l1_ ((total_bits_ - 1) / l1_bit_size + 1, 0),
-  l2_ ((total_bits_ - 1) / l2_bit_size + 1, 0)
-{
-  std::size_t l1_idx = 0;
-  std::size_t l2_idx = 0;
-  std::size_t l1_sum = 0;
-  std::size_t l2_sum = 0;
-  uintword_t word = 0;
-  std::size_t word_pos = 0;
+      if constexpr (Value)
+        return ones;
+      else
+        return pos - ones;
+    }
 
-  for (auto const [index, bit] : bits | utils::views::enumerate)
+template <typename Derived>
+  template <bool Value>
+    constexpr std::size_t
+    succinct_bitset_interface<Derived>::select (std::size_t k) const noexcept
     {
-      if (bit)
-        {
-          word |= (static_cast<uintword_t> (1) << (index % word_bit_size));
-          ++l2_sum;
-          ++l1_sum;
-          ++total_set_bits_;
-        }
-      if ((index + 1) % word_bit_size == 0 || index + 1 == total_bits_)
+      auto const &self = derived ();
+      auto const total = Value ? self.total_set_bits_ : self.total_bits_ - self.total_set_bits_;
+      if (k >= total)
+        return self.total_bits_;
+
+      // The superblock the bit lies in is the last one with at most k bits
+      // before it, and lies between the samples around the bit.
+      auto const &samples = Value ? self.ones_samples_ : self.zeros_samples_;
+      auto const sample = k / select_sample_rate;
+      auto first = samples[sample];
+      auto last = sample + 1 < sample_count (total) ? samples[sample + 1] + 1 : superblock_count (self.total_bits_);
+      while (1 < last - first)
         {
-          bits_[word_pos++] = word;
-          word = 0;
+          auto const middle = first + (last - first) / 2;
+          if (count_before_superblock<Value> (middle) <= k)
+            first = middle;
+          else
+            last = middle;
         }
-      if ((index + 1) % l2_bit_size == 0 || index + 1 == total_bits_)
-        {
-          l2_[l2_idx++] = static_cast<std::uint16_t> (l2_sum);
-          l2_sum = 0;
-        }
-      if ((index + 1) % l1_bit_size == 0 || index + 1 == total_bits_)
+      k -= count_before_superblock<Value> (first);
+
+      // Likewise for the word within the superblock.
+      first *= superblock_words;
+      last = std::min (first + superblock_words, word_count (self.total_bits_));
+      while (1 < last - first)
         {
-          l1_[l1_idx++] = l1_sum;
-          l1_sum = 0;
+          auto const middle = first + (last - first) / 2;
+          if (count_before_word<Value> (middle) <= k)
+            first = middle;
+          else
+            last = middle;
         }
+      k -= count_before_word<Value> (first);
+
+      auto const word = Value ? self.bits_[first] : ~self.bits_[first];
+      return first * word_size + select_in_word (word, k);
     }
-  // Zero-fill any remaining words if input is shorter than total_bits_
-  while (word_pos < bits_.size())
-    {
-      bits_[word_pos++] = word;
-      word = 0;
-    }
-  while (l2_idx < l2_.size())
-    l2_[l2_idx++] = 0;
-  while (l1_idx < l1_.size())
-    l1_[l1_idx++] = 0;
-}
 
+template <std::size_t N>
+  constexpr succinct_bitset<N>::succinct_bitset (std::from_range_t,
+                                                 utils::container_compatible_range<bool> auto &&bits)
+  {
+    for (auto const [index, bit] : bits | utils::views::enumerate)
+      if (bit)
+        bits_[index / word_size] |= word_type { 1 } << (index % word_size);
+
+    this->index ();
+  }
 
-[[nodiscard]] constexpr std::size_t
-succinct_bitset<std::dynamic_extent>::size () const noexcept
+template <std::size_t N>
+  [[nodiscard]] consteval std::size_t
+  succinct_bitset<N>::size () const noexcept
+  {
+    return N;
+  }
+
+constexpr succinct_bitset<std::dynamic_extent>::succinct_bitset (std::from_range_t,
+                                                                 utils::container_compatible_range<bool> auto &&bits)
+: total_bits_ (std::ranges::size (bits)),
+  bits_ (word_count (total_bits_), 0),
+  l1_ (superblock_count (total_bits_) + 1, 0),
+  l2_ (word_count (total_bits_), 0)
 {
-  return total_bits_;
+  for (auto const [index, bit] : bits | utils::views::enumerate)
+    if (bit)
+      bits_[index / word_size] |= word_type { 1 } << (index % word_size);
+
+  index ();
 }
 
-[[nodiscard]] constexpr std::size_t
-succinct_bitset<std::dynamic_extent>::count () const noexcept
+constexpr succinct_bitset<std::dynamic_extent>::succinct_bitset (std::vector<word_type> words,
+                                                                 std::size_t const size)
+: total_bits_ (size),
+  bits_ (std::move (words)),
+  l1_ (superblock_count (size) + 1, 0),
+  l2_ (word_count (size), 0)
 {
-  return total_set_bits_;
+  bits_.resize (word_count (size), 0);
+  index ();
 }
 
-constexpr bool
-succinct_bitset<std::dynamic_extent>::at(std::size_t pos) const noexcept
+[[nodiscard]] constexpr std::size_t
+succinct_bitset<std::dynamic_extent>::size () const noexcept
 {
-  if (pos >= total_bits_)
-    return false;
-  std::size_t word_idx = pos / word_bit_size;
-  std::size_t bit_idx = pos % word_bit_size;
-  return (bits_[word_idx] >> bit_idx) & 1;
+  return total_bits_;
 }
 
-
-template <bool Value>
-  constexpr std::size_t succinct_bitset<std::dynamic_extent>::rank(std::size_t pos) const noexcept
-  {
-    pos = std::min(pos, total_bits_);
-    std::size_t res = 0;
-    std::size_t l1_blocks = pos / l1_bit_size;
-    std::size_t l2_blocks = pos / l2_bit_size;
-    std::size_t word_idx = pos / word_bit_size;
-    std::size_t bit_idx = pos % word_bit_size;
-
-    if constexpr (Value)
-      {
-        if (l1_blocks)
-          res += l1_[l1_blocks - 1];
-        if (l2_blocks)
-          res += l2_[l2_blocks - 1];
-        for (std::size_t i = l2_blocks * (l2_bit_size / word_bit_size); i < word_idx; ++i)
-          res += std::popcount(bits_[i]);
-        if (bit_idx)
-          res += std::popcount(bits_[word_idx] & ((static_cast<uintword_t> (1) << bit_idx) - 1));
-        return res;
-      }
-    else
-      {
-        return pos - rank<true>(pos);
-      }
-  }
-
-template <bool Value>
-  constexpr std::size_t succinct_bitset<std::dynamic_extent>::select(std::size_t k) const noexcept
-  {
-    if constexpr (Value)
-      {
-        if (k >= total_set_bits_)
-          return total_bits_;
-      }
-    else
-      {
-        if (k >= total_bits_ - total_set_bits_)
-          return total_bits_;
-      }
-
-    std::size_t l1_acc = 0, l1_idx = 0;
-    // Find superblock
-    while (l1_idx < l1_.size() &&
-           ((Value ? l1_acc + l1_[l1_idx] : (l1_idx + 1) * l1_bit_size - (l1_acc + l1_[l1_idx])) <= k))
-      {
-        l1_acc += l1_[l1_idx];
-        ++l1_idx;
-      }
-    std::size_t l2_base = l1_idx * (l1_bit_size / l2_bit_size);
-    std::size_t l2_acc = l1_acc, l2_idx = l2_base;
-    // Find block
-    while (l2_idx < l2_.size() &&
-           ((Value ? l2_acc + l2_[l2_idx] : (l2_idx + 1) * l2_bit_size - (l2_acc + l2_[l2_idx])) <= k))
-      {
-        l2_acc += l2_[l2_idx];
-        ++l2_idx;
-      }
-    std::size_t word_base = l2_idx * (l2_bit_size / word_bit_size);
-    std::size_t acc = l2_acc;
-    // Find word
-    std::size_t word_idx = word_base;
-    for (; word_idx < bits_.size(); ++word_idx)
-      {
-        std::size_t pop = Value ? std::popcount(bits_[word_idx]) : word_bit_size - std::popcount(bits_[word_idx]);
-        if (acc + pop > k)
-          break;
-        acc += pop;
-      }
-    // Find bit in word
-    uintword_t w = bits_[word_idx];
-    for (std::size_t b = 0; b < word_bit_size && word_idx * word_bit_size + b < total_bits_; ++b)
-      {
-        bool bit = (w >> b) & 1;
-        if (bit == Value)
-          {
-            if (acc == k)
-              return word_idx * word_bit_size + b;
-            ++acc;
-          }
-      }
-    return total_bits_;
-  }
-
-} // namespace char_db::containers
\ No newline at end of file
+} // namespace char_db::containers
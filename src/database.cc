@@ -1,11 +1,29 @@
 export module vspefs.char_db : database;
 
+import : simd;
+import : ucd;
 import std;
 
 
 // concepts & interfaces
 namespace char_db {
 
+// The length and the value of the character a sequence begins with. On
+// failure, mblen is 0 and code_point is U+FFFD.
+export struct decode_result
+{
+  std::size_t mblen;
+  char32_t code_point;
+};
+
+// How far a bulk counter got: the characters in the first units of a
+// sequence, ending on a character boundary.
+struct prefix_count
+{
+  std::size_t units;
+  std::size_t chars;
+};
+
 template <typename T>
   concept minimal_database_interface = requires (
       std::vector<typename T::char_type> seq,
@@ -37,12 +55,51 @@ export template <typename T, typename CharT> concept database_of =
       { T::is_valid_char (seq) } -> std::same_as<bool>;
       { T::starts_with_valid_char (seq) } -> std::same_as<bool>;
       { T::validate_char_sequence (seq) } -> std::same_as<bool>;
+      // decode_front () is front_mblen () and to_code_point () in one go
+      { T::decode_front (seq) } -> std::same_as<decode_result>;
 
       // TODO: make it allocator-aware; write a documentation on its specific behavior
       { T::template code_point_to<std::vector<typename T::char_type>> (code_point) }
         -> std::same_as<std::vector<typename T::char_type>>;
     };
 
+// The units of one encoded character, held inline. Empty if the code point
+// could not be encoded.
+export template <typename CharT, std::size_t Capacity>
+  class encoded_char
+  {
+  public:
+    using value_type = CharT;
+
+    constexpr CharT *data () noexcept { return units_.data (); }
+    constexpr CharT const *data () const noexcept { return units_.data (); }
+    constexpr std::size_t size () const noexcept { return size_; }
+    constexpr bool empty () const noexcept { return 0 == size_; }
+
+    constexpr CharT *begin () noexcept { return data (); }
+    constexpr CharT const *begin () const noexcept { return data (); }
+    constexpr CharT *end () noexcept { return data () + size_; }
+    constexpr CharT const *end () const noexcept { return data () + size_; }
+
+    constexpr CharT operator[] (std::size_t const index) const noexcept { return units_[index]; }
+
+    constexpr operator std::span<CharT const> () const noexcept { return { data (), size_ }; }
+
+    static constexpr std::size_t capacity () noexcept { return Capacity; }
+
+  private:
+    template <typename, typename> friend class database_interface;
+
+    std::array<CharT, Capacity> units_ {};
+    std::size_t size_ = 0;
+  };
+
+template <typename R>
+  concept contiguous_sized_range = std::ranges::contiguous_range<R> && std::ranges::sized_range<R>;
+
+// Databases may declare max_mblen, the longest character they encode. The
+// contiguous algorithms then decode through windows of that static extent,
+// so the only bounds check left is the one per character on the window.
 export template <typename D, typename CharT>
   class database_interface
   {
@@ -55,6 +112,8 @@ export template <typename D, typename CharT>
     requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
     static constexpr std::size_t char_size (R &&);
 
+    static constexpr std::size_t char_size (std::span<CharT const>) noexcept;
+
     template <std::ranges::input_range R>
     requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
     static constexpr bool starts_with_valid_char (R &&);
@@ -63,6 +122,24 @@ export template <typename D, typename CharT>
     requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
     static constexpr bool validate_char_sequence (R &&);
 
+    static constexpr bool validate_char_sequence (std::span<CharT const>) noexcept;
+
+    template <std::ranges::input_range R>
+    requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+    static constexpr decode_result decode_front (R &&);
+
+    // Encodes without allocating, into as many units as D::max_mblen, or 4
+    // if D does not declare it.
+    static constexpr auto encode (char32_t) noexcept;
+
+    // Where the character ending at last begins, for stepping backwards:
+    // last minus the length of the nearest valid character, or minus one
+    // unit if none ends there. Databases whose encoding can be
+    // resynchronized from any unit provide their own, which only look at
+    // the units and leave validating the character to the caller.
+    template <std::bidirectional_iterator I>
+    static constexpr I char_start_before (I first, I last);
+
     template <std::ranges::range R>
     requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
     static constexpr R code_point_to (char32_t);
@@ -87,6 +164,9 @@ template <typename D, typename CharT>
     constexpr std::size_t
     database_interface<D, CharT>::char_size (R &&seq)
     {
+      if constexpr (contiguous_sized_range<R>)
+        return char_size (std::span<CharT const> (std::ranges::data (seq), std::ranges::size (seq)));
+
       auto const sentinel = std::ranges::cend (seq);
       auto cursor = std::ranges::cbegin (seq);
       std::size_t size = 0, mblen = 0;
@@ -104,6 +184,42 @@ template <typename D, typename CharT>
       return size;
     }
 
+template <typename D, typename CharT>
+  constexpr std::size_t
+  database_interface<D, CharT>::char_size (std::span<CharT const> const seq) noexcept
+  {
+    auto cursor = seq.data ();
+    auto const last = cursor + seq.size ();
+    std::size_t size = 0, mblen = 0;
+
+    // Databases may provide a bulk counter for contiguous input, which
+    // counts as far as it can and leaves the rest to the walk below.
+    if constexpr (requires { { D::count_contiguous (seq) } -> std::same_as<prefix_count>; })
+      if !consteval
+        {
+          auto const counted = D::count_contiguous (seq);
+          cursor += counted.units;
+          size = counted.chars;
+        }
+
+    if constexpr (requires { D::max_mblen; })
+      for (; static_cast<std::size_t> (last - cursor) >= D::max_mblen; cursor += mblen, ++size)
+        {
+          mblen = D::front_mblen (std::span<CharT const, D::max_mblen> (cursor, D::max_mblen));
+          if (0 == mblen)
+            return size;
+        }
+
+    for (; last != cursor; cursor += mblen, ++size)
+      {
+        mblen = D::front_mblen (std::span<CharT const> (cursor, last));
+        if (0 == mblen)
+          break;
+      }
+
+    return size;
+  }
+
 template <typename D, typename CharT>
   template <std::ranges::input_range R>
   requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
@@ -119,6 +235,10 @@ template <typename D, typename CharT>
     constexpr bool
     database_interface<D, CharT>::validate_char_sequence (R &&seq)
     {
+      if constexpr (contiguous_sized_range<R>)
+        return validate_char_sequence (std::span<CharT const> (std::ranges::data (seq),
+                                                               std::ranges::size (seq)));
+
       auto const sentinel = std::ranges::cend (seq);
       auto cursor = std::ranges::cbegin (seq);
       std::size_t mblen = 0;
@@ -135,18 +255,105 @@ template <typename D, typename CharT>
       return true;
     }
 
+template <typename D, typename CharT>
+  constexpr bool
+  database_interface<D, CharT>::validate_char_sequence (std::span<CharT const> const seq) noexcept
+  {
+    // Databases may provide a bulk validator for contiguous input, which
+    // must agree exactly with the walk below.
+    if constexpr (requires { { D::validate_contiguous (seq) } -> std::same_as<bool>; })
+      if !consteval
+        {
+          return D::validate_contiguous (seq);
+        }
+
+    auto cursor = seq.data ();
+    auto const last = cursor + seq.size ();
+    std::size_t mblen = 0;
+
+    if constexpr (requires { D::max_mblen; })
+      for (; static_cast<std::size_t> (last - cursor) >= D::max_mblen; cursor += mblen)
+        {
+          mblen = D::front_mblen (std::span<CharT const, D::max_mblen> (cursor, D::max_mblen));
+          if (0 == mblen)
+            return false;
+        }
+
+    for (; last != cursor; cursor += mblen)
+      {
+        mblen = D::front_mblen (std::span<CharT const> (cursor, last));
+        if (0 == mblen)
+          return false;
+      }
+
+    return true;
+  }
+
+template <typename D, typename CharT>
+  template <std::ranges::input_range R>
+  requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+    constexpr decode_result
+    database_interface<D, CharT>::decode_front (R &&seq)
+    {
+      if (auto const mblen = D::front_mblen (seq);
+          0 != mblen)
+        return { mblen, D::to_code_point (seq) };
+      else
+        return { 0, ucd::replacement_character };
+    }
+
 template <typename D, typename CharT>
   template <std::ranges::range R>
   requires std::same_as<CharT, std::remove_cvref_t<std::ranges::range_value_t<R>>>
     constexpr R
     database_interface<D, CharT>::code_point_to (char32_t const code_point)
     {
-      auto const len = D::code_unit_size (code_point);
-      auto tmp = std::vector<CharT> (len);
-      D::code_point_on (code_point, tmp);
-      return std::move (tmp) | std::ranges::to<R>;
+      return encode (code_point) | std::ranges::to<R>;
+    }
+
+template <typename D, typename CharT>
+  template <std::bidirectional_iterator I>
+    constexpr I
+    database_interface<D, CharT>::char_start_before (I const first, I const last)
+    {
+      auto start = last;
+      for (std::size_t length = 1; first != start; ++length)
+        {
+          --start;
+          if (D::is_valid_char (std::ranges::subrange (start, last)))
+            return start;
+
+          if constexpr (requires { D::max_mblen; })
+            if (D::max_mblen == length)
+              break;
+        }
+
+      return std::ranges::prev (last);
     }
 
+template <typename D, typename CharT>
+  constexpr auto
+  database_interface<D, CharT>::encode (char32_t const code_point) noexcept
+  {
+    constexpr auto capacity = []
+      {
+        if constexpr (requires { D::max_mblen; })
+          return D::max_mblen;
+        else
+          return std::size_t { 4 };
+      } ();
+
+    auto result = encoded_char<CharT, capacity> ();
+    if (auto const len = D::code_unit_size (code_point);
+        0 != len && len <= capacity)
+      {
+        D::code_point_on (code_point, std::span<CharT> (result.units_.data (), len));
+        result.size_ = len;
+      }
+
+    return result;
+  }
+
 } // namespace char_db
 
 
@@ -157,15 +364,8 @@ export class utf32 : public database_interface<utf32, char32_t>
 {
 public:
   using char_type = char32_t;
+  static constexpr std::size_t max_mblen = 1;
 
-private:
-  struct assigned_range_t
-  {
-    char32_t const start;
-    char32_t const end;
-  };
-
-public:
   template <std::ranges::input_range R>
   requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
   static constexpr std::size_t front_mblen (R &&seq);
@@ -181,27 +381,28 @@ public:
 
   static constexpr bool is_valid_code_point (char32_t code_point);
 
-private:
-  static constexpr auto assigned_ranges = std::to_array<assigned_range_t> ({
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
-#include <char_db/generated/just_ranges.inc>
-#pragma clang diagnostic pop
-      });
+  // The index of the first invalid element, or the size of seq if there
+  // is none.
+  static constexpr std::size_t valid_prefix_length (std::span<char_type const> seq) noexcept;
+
+  template <std::bidirectional_iterator I>
+  static constexpr I char_start_before (I first, I last);
+
+  static bool validate_contiguous (std::span<char_type const>) noexcept;
+  static prefix_count count_contiguous (std::span<char_type const>) noexcept;
+
+  // Which of the 64 units at first begin a character, given that they
+  // are valid; bit k stands for first[k].
+  static std::uint64_t char_starts (char_type const *first) noexcept;
 };
 
 export class utf16 : public database_interface<utf16, char16_t>
 {
 public:
   using char_type = char16_t;
+  static constexpr std::size_t max_mblen = 2;
 
 private:
-  struct assigned_range_t
-  {
-    char32_t const start;
-    char32_t const end;
-  };
-
   struct surrogate_range_t
   {
     char16_t const start;
@@ -221,13 +422,22 @@ public:
 
   template <std::ranges::input_range R>
   requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
-  constexpr char32_t to_code_point (R &&);
+  static constexpr char32_t to_code_point (R &&);
 
   static constexpr std::size_t code_unit_size (char32_t);
 
   template <std::size_t Extent = std::dynamic_extent>
   static constexpr void code_point_on (char32_t, std::span<char_type, Extent>);
 
+  static constexpr std::size_t trivial_code_unit_size (char32_t code_point) noexcept;
+
+  template <std::bidirectional_iterator I>
+  static constexpr I char_start_before (I first, I last);
+
+  static bool validate_contiguous (std::span<char_type const>) noexcept;
+  static prefix_count count_contiguous (std::span<char_type const>) noexcept;
+  static std::uint64_t char_starts (char_type const *) noexcept;
+
   static constexpr char32_t surrogate_pair_to_code_point (surrogate_pair_t) noexcept;
 
   static constexpr surrogate_pair_t code_point_to_surrogate_pair (char32_t code_point);
@@ -241,18 +451,6 @@ public:
   static constexpr bool is_non_bmp_code_point (char32_t  code_point) noexcept;
 
 private:
-  static constexpr auto bmp_assigned_ranges = std::to_array<assigned_range_t> ({
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
-#include <char_db/generated/bmp_ranges.inc>
-#pragma clang diagnostic pop
-      });
-  static constexpr auto non_bmp_assigned_ranges = std::to_array<assigned_range_t> ({
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
-#include <char_db/generated/non_bmp_ranges.inc>
-#pragma clang diagnostic pop
-      });
   static constexpr auto high_surrogate_range = surrogate_range_t { 0xD800u, 0xDC00u };
   static constexpr auto low_surrogate_range = surrogate_range_t { 0xDC00u, 0xE000u };
 };
@@ -261,16 +459,9 @@ export class utf8 : public database_interface<utf8, char8_t>
 {
 public:
   using char_type = char8_t;
+  static constexpr std::size_t max_mblen = 4;
   static constexpr std::size_t from_continuation_byte = 0;
 
-private:
-  struct assigned_range_t
-  {
-    char32_t const start;
-    char32_t const end;
-  };
-
-public:
   template <std::ranges::input_range R>
   requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
   static constexpr std::size_t front_mblen (R &&seq);
@@ -284,35 +475,55 @@ public:
   template <std::size_t Extent = std::dynamic_extent>
   static constexpr void code_point_on (char32_t, std::span<char_type, Extent>);
 
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr decode_result decode_front (R &&seq);
+
+  // Like decode_front (), but accepts unassigned code points.
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr decode_result decode_front_wellformed (R &&seq);
+
+  template <std::bidirectional_iterator I>
+  static constexpr I char_start_before (I first, I last);
+
+  static bool validate_contiguous (std::span<char_type const>) noexcept;
+  static prefix_count count_contiguous (std::span<char_type const>) noexcept;
+  static std::uint64_t char_starts (char_type const *) noexcept;
+
   static constexpr std::size_t trivial_mblen_from_unit (char_type unit) noexcept;
+  static constexpr std::size_t trivial_code_unit_size (char32_t code_point) noexcept;
   static constexpr char32_t extract_bits_from_code_unit (char_type code_unit, std::size_t trivial_mblen) noexcept;
   static constexpr bool is_continuation_unit (char_type code_unit) noexcept;
 
 private:
-  static constexpr auto assigned_ranges_1 = std::to_array<assigned_range_t> ({
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
-#include <char_db/generated/utf8_ranges_1.inc>
-#pragma clang diagnostic pop
-      });
-  static constexpr auto assigned_ranges_2 = std::to_array<assigned_range_t> ({
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
-#include <char_db/generated/utf8_ranges_2.inc>
-#pragma clang diagnostic pop
-      });
-  static constexpr auto assigned_ranges_3 = std::to_array<assigned_range_t> ({
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
-#include <char_db/generated/utf8_ranges_3.inc>
-#pragma clang diagnostic pop
-      });
-  static constexpr auto assigned_ranges_4 = std::to_array<assigned_range_t> ({
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
-#include <char_db/generated/utf8_ranges_4.inc>
-#pragma clang diagnostic pop
-      });
+  // Bjoern Hoehrmann's UTF-8 decoder DFA. Every unit maps to one of twelve
+  // classes, and states are pre-multiplied by twelve so the transition is
+  // a single lookup. The class also tells how many payload bits a lead
+  // unit carries.
+  static constexpr std::uint8_t dfa_accept = 0;
+  static constexpr std::uint8_t dfa_reject = 12;
+
+  static constexpr auto dfa_classes = std::to_array<std::uint8_t> ({
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+      7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+      8, 8, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+      10, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 3, 3, 11, 6, 6, 6, 5, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8 });
+
+  static constexpr auto dfa_transitions = std::to_array<std::uint8_t> ({
+      0, 12, 24, 36, 60, 96, 84, 12, 12, 12, 48, 72,
+      12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+      12, 0, 12, 12, 12, 12, 12, 0, 12, 0, 12, 12,
+      12, 24, 12, 12, 12, 12, 12, 24, 12, 24, 12, 12,
+      12, 12, 12, 12, 12, 12, 12, 24, 12, 12, 12, 12,
+      12, 24, 12, 12, 12, 12, 12, 12, 12, 24, 12, 12,
+      12, 12, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12,
+      12, 36, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12,
+      12, 36, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12 });
 };
 
 template <std::ranges::input_range R>
@@ -347,23 +558,119 @@ template <std::size_t Extent = std::dynamic_extent>
 constexpr bool
 utf32::is_valid_code_point (char32_t const code_point)
 {
-  std::size_t low = 0;
-  std::size_t high = assigned_ranges.size () - 1;
-  while (low <= high)
-    if (std::size_t const mid = low + (high - low) / 2;
-        code_point < assigned_ranges[mid].start)
+  return ucd::is_assigned (code_point);
+}
+
+constexpr std::size_t
+utf32::valid_prefix_length (std::span<char32_t const> const seq) noexcept
+{
+  if !consteval
+    {
+      return simd::assigned_prefix_length (seq.data (), seq.data () + seq.size ());
+    }
+
+  return static_cast<std::size_t> (std::ranges::find_if_not (seq, is_valid_code_point) - seq.begin ());
+}
+
+template <std::bidirectional_iterator I>
+  constexpr I
+  utf32::char_start_before (I, I const last)
+  {
+    return std::ranges::prev (last);
+  }
+
+bool
+utf32::validate_contiguous (std::span<char32_t const> const seq) noexcept
+{
+  return valid_prefix_length (seq) == seq.size ();
+}
+
+prefix_count
+utf32::count_contiguous (std::span<char32_t const> const seq) noexcept
+{
+  auto const length = valid_prefix_length (seq);
+  return { length, length };
+}
+
+std::uint64_t
+utf32::char_starts (char32_t const *) noexcept
+{
+  return ~std::uint64_t { 0 };
+}
+
+// Bulk counting goes in blocks ending on character boundaries. A block is
+// counted with popcounts once it is known to be valid, and the first one
+// that is not is left to the walk in char_size ().
+inline constexpr std::size_t count_block_size = 1024;
+
+template <bool CheckAssigned>
+  prefix_count
+  count_utf8_prefix (std::span<char8_t const> const seq) noexcept
+  {
+    auto count = prefix_count { 0, 0 };
+    std::array<char32_t, count_block_size> code_points;
+
+    while (count.units < seq.size ())
       {
-        if (0 == mid)
-          return 0;
-        high = mid - 1;
+        auto const rest = seq.subspan (count.units);
+        auto length = std::min (count_block_size, rest.size ());
+        for (std::size_t i = 0;
+             i < utf8::max_mblen - 1 && 0 != length && length < rest.size ()
+             && utf8::is_continuation_unit (rest[length]);
+             ++i)
+          --length;
+
+        auto const first = rest.data (), last = rest.data () + length;
+        auto const structure = simd::check_utf8_structure (first, last);
+        if (0 == length || simd::utf8_structure::ill_formed == structure)
+          break;
+
+        if (simd::utf8_structure::ascii == structure)
+          count.chars += length;
+        else if (CheckAssigned)
+          {
+            // Checking assignment needs the code points anyway, and
+            // decoding them counts them.
+            auto const decoded = simd::utf8_to_utf32 (first, last, code_points.data ());
+            if (!ucd::all_assigned (std::span<char32_t const> (code_points.data (), decoded)))
+              break;
+            count.chars += decoded;
+          }
+        else
+          count.chars += simd::utf8_to_utf32_length (first, last);
+
+        count.units += length;
       }
-    else if (assigned_ranges[mid].end <= code_point)
-      low = mid + 1;
-    else
-      return true;
 
-  return false;
-}
+    return count;
+  }
+
+template <bool CheckAssigned>
+  prefix_count
+  count_utf16_prefix (std::span<char16_t const> const seq) noexcept
+  {
+    auto count = prefix_count { 0, 0 };
+
+    while (count.units < seq.size ())
+      {
+        auto const rest = seq.subspan (count.units);
+        auto length = std::min (count_block_size, rest.size ());
+        if (length < rest.size () && utf16::is_high_surrogate (rest[length - 1]))
+          --length;
+
+        auto const block = rest.first (length);
+        if (0 == length
+            || simd::utf16_structure::ill_formed == simd::check_utf16_structure (block.data (),
+                                                                                 block.data () + length)
+            || (CheckAssigned && !ucd::all_assigned (block)))
+          break;
+
+        count.chars += simd::utf16_to_utf32_length (block.data (), block.data () + length);
+        count.units += length;
+      }
+
+    return count;
+  }
 
 template <std::ranges::input_range R>
 requires std::same_as<char16_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
@@ -376,10 +683,11 @@ requires std::same_as<char16_t, std::remove_cvref_t<std::ranges::range_value_t<R
         if (std::ranges::size (seq) < 2)
           return 0;
 
-        char32_t const code_point = surrogate_pair_to_code_point ({
-            *first_iter,
-            *std::ranges::next (first_iter) });
+        auto const second = *std::ranges::next (first_iter);
+        if (!is_low_surrogate (second))
+          return 0;
 
+        char32_t const code_point = surrogate_pair_to_code_point ({ *first_iter, second });
         return is_non_bmp_code_point (code_point) ? 2 : 0;
       }
     else
@@ -415,7 +723,7 @@ template <std::size_t Extent = std::dynamic_extent>
   constexpr void
   utf16::code_point_on (char32_t const code_point, std::span<char16_t, Extent> const dest)
   {
-    switch (code_unit_size (code_point))
+    switch (trivial_code_unit_size (code_point))
       {
       default:
         std::unreachable ();
@@ -430,6 +738,12 @@ template <std::size_t Extent = std::dynamic_extent>
       }
   }
 
+constexpr std::size_t
+utf16::trivial_code_unit_size (char32_t const code_point) noexcept
+{
+  return 0xFFFFU < code_point ? 2 : 1;
+}
+
 constexpr char32_t
 utf16::surrogate_pair_to_code_point (surrogate_pair_t const pair) noexcept
 {
@@ -446,6 +760,38 @@ utf16::code_point_to_surrogate_pair (char32_t code_point)
            static_cast<char16_t> ((code_point & 0x3FF) + low_surrogate_range.start) };
 }
 
+template <std::bidirectional_iterator I>
+  constexpr I
+  utf16::char_start_before (I const first, I const last)
+  {
+    auto start = std::ranges::prev (last);
+    if (first != start && is_low_surrogate (*start) && is_high_surrogate (*std::ranges::prev (start)))
+      --start;
+    return start;
+  }
+
+// Surrogate pairing is checked for the whole sequence with vector masks
+// first, after which assignment is a table lookup per character.
+bool
+utf16::validate_contiguous (std::span<char16_t const> const seq) noexcept
+{
+  return simd::utf16_structure::ill_formed
+         != simd::check_utf16_structure (seq.data (), seq.data () + seq.size ())
+         && ucd::all_assigned (seq);
+}
+
+prefix_count
+utf16::count_contiguous (std::span<char16_t const> const seq) noexcept
+{
+  return count_utf16_prefix<true> (seq);
+}
+
+std::uint64_t
+utf16::char_starts (char16_t const *const first) noexcept
+{
+  return simd::utf16_char_starts (first);
+}
+
 constexpr bool
 utf16::is_high_surrogate (char16_t const code_unit) noexcept
 {
@@ -461,42 +807,13 @@ utf16::is_low_surrogate (char16_t const code_unit) noexcept
 constexpr bool
 utf16::is_bmp_code_point (char32_t const code_point) noexcept
 {
-  std::size_t low = 0;
-  std::size_t high = bmp_assigned_ranges.size () - 1;
-  while (low <= high)
-    if (std::size_t const mid = low + (high - low) / 2; code_point < bmp_assigned_ranges[mid].start)
-      {
-        if (0 == mid)
-          return false;
-        high = mid - 1;
-      }
-    else if (bmp_assigned_ranges[mid].end <= code_point)
-      low = mid + 1;
-    else
-      return true;
-
-  return false;
+  return code_point <= 0xFFFFU && ucd::is_assigned (code_point);
 }
 
 constexpr bool
 utf16::is_non_bmp_code_point (char32_t const code_point) noexcept
 {
-  std::size_t low = 0;
-  std::size_t high = non_bmp_assigned_ranges.size () - 1;
-  while (low <= high)
-    if (std::size_t const mid = low + (high - low) / 2;
-        code_point < non_bmp_assigned_ranges[mid].start)
-      {
-        if (0 == mid)
-          return false;
-        high = mid - 1;
-      }
-    else if (non_bmp_assigned_ranges[mid].end <= code_point)
-      low = mid + 1;
-    else
-      return true;
-
-  return false;
+  return 0xFFFFU < code_point && ucd::is_assigned (code_point);
 }
 
 template <std::ranges::input_range R>
@@ -504,110 +821,84 @@ requires std::same_as<char8_t, std::remove_cvref_t<std::ranges::range_value_t<R>
   constexpr std::size_t
   utf8::front_mblen (R &&seq)
   {
-    using span_type = std::span<assigned_range_t const, std::dynamic_extent>;
+    return decode_front (seq).mblen;
+  }
 
+template <std::ranges::input_range R>
+requires std::same_as<char8_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr char32_t
+  utf8::to_code_point (R &&seq)
+  {
     auto const trivial_mblen = trivial_mblen_from_unit (*std::ranges::cbegin (seq));
-    if (0 == trivial_mblen || std::ranges::size (seq) < trivial_mblen)
-      return 0;
 
     char32_t code_point = extract_bits_from_code_unit (*std::ranges::cbegin (seq), trivial_mblen);
+
     auto cursor = std::ranges::cbegin (seq);
     for (std::size_t i = 0; i < trivial_mblen - 1; ++i)
       {
         std::ranges::advance (cursor, 1);
-        if (is_continuation_unit (*cursor))
-          code_point = code_point << 6 | extract_bits_from_code_unit (*cursor, from_continuation_byte);
-        else
-          return 0;
-      }
-
-    auto const assigned_ranges =
-        trivial_mblen == 1 ? span_type (assigned_ranges_1) :
-        trivial_mblen == 2 ? span_type (assigned_ranges_2) :
-        trivial_mblen == 3 ? span_type (assigned_ranges_3) :
-        span_type (assigned_ranges_4);
-
-    std::size_t low = 0;
-    std::size_t high = std::ranges::ssize (assigned_ranges) - 1;
-    while (low <= high)
-      {
-        if (std::size_t const mid = low + (high - low) / 2;
-            code_point < assigned_ranges[mid].start)
-          {
-            if (0 == mid)
-              return 0;
-            high = mid - 1;
-          }
-        else if (assigned_ranges[mid].end <= code_point)
-          low = mid + 1;
-        else
-          return trivial_mblen;
+        code_point <<= 6;
+        code_point |= extract_bits_from_code_unit (*cursor, from_continuation_byte);
       }
 
-    return 0;
+    return code_point;
   }
 
 template <std::ranges::input_range R>
 requires std::same_as<char8_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
-  constexpr char32_t
-  utf8::to_code_point (R &&seq)
+  constexpr decode_result
+  utf8::decode_front (R &&seq)
   {
-    auto const trivial_mblen = trivial_mblen_from_unit (*std::ranges::cbegin (seq));
-
-    char32_t code_point = extract_bits_from_code_unit (*std::ranges::cbegin (seq), trivial_mblen);
+    if (auto const result = decode_front_wellformed (seq);
+        0 != result.mblen && ucd::is_assigned (result.code_point))
+      return result;
+    else
+      return { 0, ucd::replacement_character };
+  }
 
+template <std::ranges::input_range R>
+requires std::same_as<char8_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr decode_result
+  utf8::decode_front_wellformed (R &&seq)
+  {
+    auto const sentinel = std::ranges::cend (seq);
     auto cursor = std::ranges::cbegin (seq);
-    for (std::size_t i = 0; i < trivial_mblen - 1; ++i)
+    std::uint8_t state = dfa_accept;
+    char32_t code_point = 0;
+    std::size_t mblen = 0;
+
+    do
       {
+        if (sentinel == cursor)
+          return { 0, ucd::replacement_character };
+
+        char8_t const unit = *cursor;
+        std::uint8_t const type = dfa_classes[unit];
+        code_point = dfa_accept == state ? (0xFFU >> type) & unit
+                                         : (code_point << 6) | (unit & 0x3FU);
+        state = dfa_transitions[state + type];
+        if (dfa_reject == state)
+          return { 0, ucd::replacement_character };
+
         std::ranges::advance (cursor, 1);
-        code_point <<= 6;
-        code_point |= extract_bits_from_code_unit (*cursor, from_continuation_byte);
+        ++mblen;
       }
+    while (dfa_accept != state);
 
-    return code_point;
+    return { mblen, code_point };
   }
 
 constexpr std::size_t
 utf8::code_unit_size (char32_t const code_point)
 {
-  using span_type = std::span<assigned_range_t const, std::dynamic_extent>;
-  
-  std::size_t const trivial_size = 0xFFFFU < code_point ? 4 :
-                                   0x7FFU < code_point ? 3 :
-                                   0x7FU < code_point ? 2 :
-                                   1;
-
-  auto const assigned_ranges =
-      trivial_size == 1 ? span_type (assigned_ranges_1) :
-      trivial_size == 2 ? span_type (assigned_ranges_2) :
-      trivial_size == 3 ? span_type (assigned_ranges_3) :
-      span_type (assigned_ranges_4);
-
-  std::size_t low = 0;
-  std::size_t high = std::ranges::size (assigned_ranges) - 1;
-  while (low <= high)
-    {
-      if (std::size_t const mid = low + (high - low) / 2;
-          code_point < assigned_ranges[mid].start)
-        {
-          if (0 == mid)
-            return 0;
-          high = mid - 1;
-        }
-      else if (assigned_ranges[mid].end <= code_point)
-        low = mid + 1;
-      else
-        return trivial_size;
-    }
-
-  return 0;
+  return ucd::is_assigned (code_point) ? trivial_code_unit_size (code_point) : 0;
 }
 
 template <std::size_t Extent = std::dynamic_extent>
   constexpr void
   utf8::code_point_on (char32_t const code_point, std::span<char8_t, Extent> const dest)
   {
-    switch (code_unit_size (code_point))
+    switch (trivial_code_unit_size (code_point))
       {
       default:
         std::unreachable ();
@@ -632,6 +923,63 @@ template <std::size_t Extent = std::dynamic_extent>
       }
   }
 
+template <std::bidirectional_iterator I>
+  constexpr I
+  utf8::char_start_before (I const first, I const last)
+  {
+    auto start = std::ranges::prev (last);
+    for (std::size_t length = 1; length < max_mblen && first != start && is_continuation_unit (*start); ++length)
+      --start;
+    return start;
+  }
+
+bool
+utf8::validate_contiguous (std::span<char8_t const> const seq) noexcept
+{
+  auto cursor = seq.data ();
+  auto const last = cursor + seq.size ();
+
+  switch (simd::check_utf8_structure (cursor, last))
+    {
+    case simd::utf8_structure::ill_formed:
+      return false;
+    case simd::utf8_structure::ascii:
+      return true;
+    case simd::utf8_structure::well_formed:
+      break;
+    }
+
+  // Every character is known to be well-formed and shortest-form here, so
+  // only the multibyte ones are left to be checked for assignment.
+  while (cursor != last)
+    {
+      if (*cursor < 0x80)
+        {
+          cursor += simd::ascii_prefix_length (cursor, last);
+          continue;
+        }
+
+      auto const result = decode_front (std::span (cursor, last));
+      if (0 == result.mblen)
+        return false;
+      cursor += result.mblen;
+    }
+
+  return true;
+}
+
+prefix_count
+utf8::count_contiguous (std::span<char8_t const> const seq) noexcept
+{
+  return count_utf8_prefix<true> (seq);
+}
+
+std::uint64_t
+utf8::char_starts (char8_t const *const first) noexcept
+{
+  return simd::utf8_char_starts (first);
+}
+
 constexpr std::size_t
 utf8::trivial_mblen_from_unit (char8_t const unit) noexcept
 {
@@ -646,6 +994,15 @@ utf8::trivial_mblen_from_unit (char8_t const unit) noexcept
   return 0;
 }
 
+constexpr std::size_t
+utf8::trivial_code_unit_size (char32_t const code_point) noexcept
+{
+  return 0xFFFFU < code_point ? 4 :
+         0x7FFU < code_point ? 3 :
+         0x7FU < code_point ? 2 :
+         1;
+}
+
 constexpr char32_t
 utf8::extract_bits_from_code_unit (char8_t const code_unit,
                                    std::size_t const trivial_mblen) noexcept
@@ -676,10 +1033,525 @@ utf8::is_continuation_unit (char8_t const code_unit) noexcept
 } // namespace char_db
 
 
-// wrappers
+// well-formedness-only databases
+//
+// Siblings of the databases above that accept every Unicode scalar value,
+// assigned or not. They only check the encoding structure, surrogates and
+// the U+10FFFF limit, and never touch the UCD tables.
 namespace char_db {
 
-export template <typename T, typename CharT>
+export class utf32_wellformed : public database_interface<utf32_wellformed, char32_t>
+{
+public:
+  using char_type = char32_t;
+  static constexpr std::size_t max_mblen = 1;
+
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr std::size_t front_mblen (R &&seq);
+
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr char32_t to_code_point (R &&seq);
+
+  static constexpr std::size_t code_unit_size (char32_t);
+
+  template <std::size_t Extent = std::dynamic_extent>
+  static constexpr void code_point_on (char32_t, std::span<char_type, Extent>);
+
+  static constexpr bool is_valid_code_point (char32_t code_point) noexcept;
+
+  static constexpr std::size_t valid_prefix_length (std::span<char_type const> seq) noexcept;
+
+  template <std::bidirectional_iterator I>
+  static constexpr I char_start_before (I first, I last);
+
+  static bool validate_contiguous (std::span<char_type const>) noexcept;
+  static prefix_count count_contiguous (std::span<char_type const>) noexcept;
+  static std::uint64_t char_starts (char_type const *) noexcept;
+};
+
+export class utf16_wellformed : public database_interface<utf16_wellformed, char16_t>
+{
+public:
+  using char_type = char16_t;
+  static constexpr std::size_t max_mblen = 2;
+
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr std::size_t front_mblen (R &&seq);
+
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr char32_t to_code_point (R &&seq);
+
+  static constexpr std::size_t code_unit_size (char32_t);
+
+  template <std::size_t Extent = std::dynamic_extent>
+  static constexpr void code_point_on (char32_t, std::span<char_type, Extent>);
+
+  template <std::bidirectional_iterator I>
+  static constexpr I char_start_before (I first, I last);
+
+  static bool validate_contiguous (std::span<char_type const>) noexcept;
+  static prefix_count count_contiguous (std::span<char_type const>) noexcept;
+  static std::uint64_t char_starts (char_type const *) noexcept;
+};
+
+export class utf8_wellformed : public database_interface<utf8_wellformed, char8_t>
+{
+public:
+  using char_type = char8_t;
+  static constexpr std::size_t max_mblen = 4;
+
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr std::size_t front_mblen (R &&seq);
+
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr char32_t to_code_point (R &&seq);
+
+  static constexpr std::size_t code_unit_size (char32_t);
+
+  template <std::size_t Extent = std::dynamic_extent>
+  static constexpr void code_point_on (char32_t, std::span<char_type, Extent>);
+
+  template <std::ranges::input_range R>
+  requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  static constexpr decode_result decode_front (R &&seq);
+
+  template <std::bidirectional_iterator I>
+  static constexpr I char_start_before (I first, I last);
+
+  static bool validate_contiguous (std::span<char_type const>) noexcept;
+  static prefix_count count_contiguous (std::span<char_type const>) noexcept;
+  static std::uint64_t char_starts (char_type const *) noexcept;
+};
+
+template <std::ranges::input_range R>
+requires std::same_as<char32_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr std::size_t
+  utf32_wellformed::front_mblen (R &&seq)
+  {
+    return code_unit_size (*std::ranges::cbegin (seq));
+  }
+
+template <std::ranges::input_range R>
+requires std::same_as<char32_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr char32_t
+  utf32_wellformed::to_code_point (R &&seq)
+  {
+    return utf32::to_code_point (seq);
+  }
+
+constexpr std::size_t
+utf32_wellformed::code_unit_size (char32_t const code_point)
+{
+  return is_valid_code_point (code_point) ? 1 : 0;
+}
+
+template <std::size_t Extent>
+  constexpr void
+  utf32_wellformed::code_point_on (char32_t const code_point, std::span<char32_t, Extent> const dest)
+  {
+    utf32::code_point_on (code_point, dest);
+  }
+
+constexpr bool
+utf32_wellformed::is_valid_code_point (char32_t const code_point) noexcept
+{
+  return code_point <= ucd::max_code_point && (code_point < 0xD800U || 0xDFFFU < code_point);
+}
+
+constexpr std::size_t
+utf32_wellformed::valid_prefix_length (std::span<char32_t const> const seq) noexcept
+{
+  if !consteval
+    {
+      return simd::scalar_value_prefix_length (seq.data (), seq.data () + seq.size ());
+    }
+
+  return static_cast<std::size_t> (std::ranges::find_if_not (seq, is_valid_code_point) - seq.begin ());
+}
+
+template <std::bidirectional_iterator I>
+  constexpr I
+  utf32_wellformed::char_start_before (I const first, I const last)
+  {
+    return utf32::char_start_before (first, last);
+  }
+
+bool
+utf32_wellformed::validate_contiguous (std::span<char32_t const> const seq) noexcept
+{
+  return valid_prefix_length (seq) == seq.size ();
+}
+
+prefix_count
+utf32_wellformed::count_contiguous (std::span<char32_t const> const seq) noexcept
+{
+  auto const length = valid_prefix_length (seq);
+  return { length, length };
+}
+
+std::uint64_t
+utf32_wellformed::char_starts (char32_t const *const first) noexcept
+{
+  return utf32::char_starts (first);
+}
+
+template <std::ranges::input_range R>
+requires std::same_as<char16_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr std::size_t
+  utf16_wellformed::front_mblen (R &&seq)
+  {
+    if (auto const first_iter = std::ranges::cbegin (seq);
+        utf16::is_high_surrogate (*first_iter))
+      {
+        if (std::ranges::size (seq) < 2)
+          return 0;
+
+        return utf16::is_low_surrogate (*std::ranges::next (first_iter)) ? 2 : 0;
+      }
+    else
+      return utf16::is_low_surrogate (*first_iter) ? 0 : 1;
+  }
+
+template <std::ranges::input_range R>
+requires std::same_as<char16_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr char32_t
+  utf16_wellformed::to_code_point (R &&seq)
+  {
+    return utf16::to_code_point (seq);
+  }
+
+constexpr std::size_t
+utf16_wellformed::code_unit_size (char32_t const code_point)
+{
+  return utf32_wellformed::is_valid_code_point (code_point)
+         ? utf16::trivial_code_unit_size (code_point)
+         : 0;
+}
+
+template <std::size_t Extent>
+  constexpr void
+  utf16_wellformed::code_point_on (char32_t const code_point, std::span<char16_t, Extent> const dest)
+  {
+    utf16::code_point_on (code_point, dest);
+  }
+
+template <std::bidirectional_iterator I>
+  constexpr I
+  utf16_wellformed::char_start_before (I const first, I const last)
+  {
+    return utf16::char_start_before (first, last);
+  }
+
+bool
+utf16_wellformed::validate_contiguous (std::span<char16_t const> const seq) noexcept
+{
+  return simd::utf16_structure::ill_formed
+         != simd::check_utf16_structure (seq.data (), seq.data () + seq.size ());
+}
+
+prefix_count
+utf16_wellformed::count_contiguous (std::span<char16_t const> const seq) noexcept
+{
+  return count_utf16_prefix<false> (seq);
+}
+
+std::uint64_t
+utf16_wellformed::char_starts (char16_t const *const first) noexcept
+{
+  return utf16::char_starts (first);
+}
+
+template <std::ranges::input_range R>
+requires std::same_as<char8_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr std::size_t
+  utf8_wellformed::front_mblen (R &&seq)
+  {
+    return utf8::decode_front_wellformed (seq).mblen;
+  }
+
+template <std::ranges::input_range R>
+requires std::same_as<char8_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr char32_t
+  utf8_wellformed::to_code_point (R &&seq)
+  {
+    return utf8::to_code_point (seq);
+  }
+
+constexpr std::size_t
+utf8_wellformed::code_unit_size (char32_t const code_point)
+{
+  return utf32_wellformed::is_valid_code_point (code_point)
+         ? utf8::trivial_code_unit_size (code_point)
+         : 0;
+}
+
+template <std::size_t Extent>
+  constexpr void
+  utf8_wellformed::code_point_on (char32_t const code_point, std::span<char8_t, Extent> const dest)
+  {
+    utf8::code_point_on (code_point, dest);
+  }
+
+template <std::ranges::input_range R>
+requires std::same_as<char8_t, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+  constexpr decode_result
+  utf8_wellformed::decode_front (R &&seq)
+  {
+    return utf8::decode_front_wellformed (seq);
+  }
+
+template <std::bidirectional_iterator I>
+  constexpr I
+  utf8_wellformed::char_start_before (I const first, I const last)
+  {
+    return utf8::char_start_before (first, last);
+  }
+
+bool
+utf8_wellformed::validate_contiguous (std::span<char8_t const> const seq) noexcept
+{
+  return simd::utf8_structure::ill_formed
+         != simd::check_utf8_structure (seq.data (), seq.data () + seq.size ());
+}
+
+prefix_count
+utf8_wellformed::count_contiguous (std::span<char8_t const> const seq) noexcept
+{
+  return count_utf8_prefix<false> (seq);
+}
+
+std::uint64_t
+utf8_wellformed::char_starts (char8_t const *const first) noexcept
+{
+  return utf8::char_starts (first);
+}
+
+} // namespace char_db
+
+
+// byte-ordered databases
+//
+// UTF-16 and UTF-32 as stored in files and on the wire, in a given byte
+// order rather than the native one. Units are taken as they come, each
+// byte-swapped on access if the order is not native. Contiguous input is
+// swapped a block at a time into a buffer that stays in cache, and left
+// to the bulk algorithms of the native database.
+namespace char_db {
+
+export template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  class byte_ordered : public database_interface<byte_ordered<Db, Order>, typename Db::char_type>
+  {
+  public:
+    using char_type = typename Db::char_type;
+    using native_database = Db;
+    static constexpr std::endian byte_order = Order;
+    static constexpr std::size_t max_mblen = Db::max_mblen;
+
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+    static constexpr std::size_t front_mblen (R &&seq);
+
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+    static constexpr char32_t to_code_point (R &&seq);
+
+    static constexpr std::size_t code_unit_size (char32_t);
+
+    template <std::size_t Extent = std::dynamic_extent>
+    static constexpr void code_point_on (char32_t, std::span<char_type, Extent>);
+
+    // Resynchronizes as Db does, on the units seen in the native byte
+    // order.
+    template <std::bidirectional_iterator I>
+    static constexpr I char_start_before (I first, I last);
+
+    static bool validate_contiguous (std::span<char_type const>) noexcept;
+    static prefix_count count_contiguous (std::span<char_type const>) noexcept;
+    static std::uint64_t char_starts (char_type const *) noexcept;
+
+    // Converts a unit between Order and the native byte order, both ways.
+    static constexpr char_type to_native (char_type code_unit) noexcept;
+
+    // Copies seq to out in the native byte order, as far as a character
+    // boundary if more units follow; returns the number of units copied.
+    static constexpr std::size_t to_native (std::span<char_type const> seq, std::span<char_type> out) noexcept;
+
+  private:
+    // The units of the first character of seq, in the native byte order.
+    template <std::ranges::input_range R>
+      static constexpr auto native_front (R &&seq);
+
+    static constexpr std::size_t block_size = 1024;
+  };
+
+export using utf16le = byte_ordered<utf16, std::endian::little>;
+export using utf16be = byte_ordered<utf16, std::endian::big>;
+export using utf32le = byte_ordered<utf32, std::endian::little>;
+export using utf32be = byte_ordered<utf32, std::endian::big>;
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  template <std::ranges::input_range R>
+  requires std::same_as<typename Db::char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+    constexpr std::size_t
+    byte_ordered<Db, Order>::front_mblen (R &&seq)
+    {
+      auto const [units, size] = native_front (seq);
+      return Db::front_mblen (std::span<char_type const> (units.data (), size));
+    }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  template <std::ranges::input_range R>
+  requires std::same_as<typename Db::char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+    constexpr char32_t
+    byte_ordered<Db, Order>::to_code_point (R &&seq)
+    {
+      auto const [units, size] = native_front (seq);
+      return Db::to_code_point (std::span<char_type const> (units.data (), size));
+    }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  constexpr std::size_t
+  byte_ordered<Db, Order>::code_unit_size (char32_t const code_point)
+  {
+    return Db::code_unit_size (code_point);
+  }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  template <std::size_t Extent>
+    constexpr void
+    byte_ordered<Db, Order>::code_point_on (char32_t const code_point, std::span<char_type, Extent> const dest)
+    {
+      Db::code_point_on (code_point, dest);
+      if constexpr (std::endian::native != Order)
+        for (auto &unit : dest.first (Db::code_unit_size (code_point)))
+          unit = to_native (unit);
+    }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  template <std::bidirectional_iterator I>
+    constexpr I
+    byte_ordered<Db, Order>::char_start_before (I const first, I const last)
+    {
+      auto native = std::ranges::subrange (first, last)
+                    | std::views::transform ([] (char_type const unit) { return to_native (unit); });
+      return Db::char_start_before (native.begin (), native.end ()).base ();
+    }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  bool
+  byte_ordered<Db, Order>::validate_contiguous (std::span<char_type const> const seq) noexcept
+  {
+    std::array<char_type, block_size> block;
+
+    for (std::size_t offset = 0, length = 0; offset != seq.size (); offset += length)
+      {
+        length = to_native (seq.subspan (offset), block);
+        if (!Db::validate_char_sequence (std::span<char_type const> (block.data (), length)))
+          return false;
+      }
+
+    return true;
+  }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  prefix_count
+  byte_ordered<Db, Order>::count_contiguous (std::span<char_type const> const seq) noexcept
+  {
+    std::array<char_type, block_size> block;
+    auto count = prefix_count { 0, 0 };
+
+    while (count.units != seq.size ())
+      {
+        auto const length = to_native (seq.subspan (count.units), block);
+        auto const counted = Db::count_contiguous (std::span<char_type const> (block.data (), length));
+
+        count.units += counted.units;
+        count.chars += counted.chars;
+        if (counted.units != length)
+          break;
+      }
+
+    return count;
+  }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  std::uint64_t
+  byte_ordered<Db, Order>::char_starts (char_type const *const first) noexcept
+  {
+    std::array<char_type, 64> native;
+    std::ranges::transform (first, first + native.size (), native.begin (), [] (char_type const unit)
+                            {
+                              return to_native (unit);
+                            });
+    return Db::char_starts (native.data ());
+  }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  constexpr typename Db::char_type
+  byte_ordered<Db, Order>::to_native (char_type const code_unit) noexcept
+  {
+    if constexpr (std::endian::native == Order)
+      return code_unit;
+    else
+      return std::byteswap (code_unit);
+  }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  constexpr std::size_t
+  byte_ordered<Db, Order>::to_native (std::span<char_type const> const seq, std::span<char_type> const out) noexcept
+  {
+    auto length = std::min (seq.size (), out.size ());
+    for (std::size_t i = 0; i != length; ++i)
+      out[i] = to_native (seq[i]);
+
+    // Only UTF-16 has characters to split.
+    if constexpr (std::same_as<char_type, char16_t>)
+      if (1 < length && length < seq.size () && utf16::is_high_surrogate (out[length - 1]))
+        --length;
+
+    return length;
+  }
+
+template <typename Db, std::endian Order>
+requires (1 < sizeof (typename Db::char_type))
+  template <std::ranges::input_range R>
+    constexpr auto
+    byte_ordered<Db, Order>::native_front (R &&seq)
+    {
+      std::array<char_type, max_mblen> units {};
+      auto const last = std::ranges::copy (seq | std::views::take (max_mblen)
+                                               | std::views::transform ([] (char_type const unit)
+                                                                          {
+                                                                            return to_native (unit);
+                                                                          }),
+                                           units.begin ()).out;
+      return std::pair { units, static_cast<std::size_t> (last - units.begin ()) };
+    }
+
+} // namespace char_db
+
+
+// wrappers
+namespace char_db {
+
+export template <typename T, typename CharT>
   concept checked_database_of = requires (std::vector<CharT> seq, char32_t code_point)
   {
     requires std::same_as<typename T::char_type, CharT>;
@@ -726,6 +1598,145 @@ export enum class checked_policy : std::uint8_t
 export template <typename T, checked_policy Policy = checked_policy::nothing>
 class checked;
 
+// Why a sequence is not a valid character, or a code point cannot be
+// encoded. A lead unit that cannot start any character counts as a bad
+// continuation if it is one, as overlong for 0xC0 and 0xC1, and as out of
+// range for 0xF5 and up.
+export enum class error_code : std::uint8_t
+{
+  truncated,
+  bad_continuation,
+  overlong,
+  surrogate,
+  unassigned,
+  out_of_range,
+  // The sequence goes on past its one character.
+  excess_units,
+  // The destination is too small for the encoded code point.
+  insufficient_space,
+};
+
+// What went wrong, and the offset of the first unit of the character it
+// went wrong in.
+export struct char_error
+{
+  error_code code;
+  std::size_t offset;
+
+  friend constexpr bool operator== (char_error const &, char_error const &) = default;
+};
+
+constexpr error_code
+diagnose_code_point (char32_t const code_point) noexcept
+{
+  if (ucd::max_code_point < code_point)
+    return error_code::out_of_range;
+  if (0xD800U <= code_point && code_point < 0xE000U)
+    return error_code::surrogate;
+  return error_code::unassigned;
+}
+
+// Why seq, which is not empty, does not begin with a valid character of a
+// database of its code unit type.
+template <typename CharT>
+  constexpr error_code
+  diagnose_front (std::span<CharT const> const seq) noexcept
+  {
+    if constexpr (std::same_as<CharT, char8_t>)
+      {
+        char8_t const lead = seq[0];
+        std::size_t mblen = 0;
+
+        if (lead < 0x80)
+          return error_code::unassigned;
+        else if (lead < 0xC0)
+          return error_code::bad_continuation;
+        else if (lead < 0xC2)
+          return error_code::overlong;
+        else if (lead < 0xE0)
+          mblen = 2;
+        else if (lead < 0xF0)
+          mblen = 3;
+        else if (lead < 0xF5)
+          mblen = 4;
+        else
+          return error_code::out_of_range;
+
+        if (seq.size () < 2)
+          return error_code::truncated;
+        if (!utf8::is_continuation_unit (seq[1]))
+          return error_code::bad_continuation;
+
+        // The second unit alone rules out some leads, however the
+        // sequence would go on.
+        if (0xE0 == lead && seq[1] < 0xA0)
+          return error_code::overlong;
+        if (0xED == lead && 0x9F < seq[1])
+          return error_code::surrogate;
+        if (0xF0 == lead && seq[1] < 0x90)
+          return error_code::overlong;
+        if (0xF4 == lead && 0x8F < seq[1])
+          return error_code::out_of_range;
+
+        for (std::size_t i = 2; i < mblen; ++i)
+          {
+            if (seq.size () == i)
+              return error_code::truncated;
+            if (!utf8::is_continuation_unit (seq[i]))
+              return error_code::bad_continuation;
+          }
+
+        return error_code::unassigned;
+      }
+    else if constexpr (std::same_as<CharT, char16_t>)
+      {
+        if (utf16::is_low_surrogate (seq[0]))
+          return error_code::surrogate;
+        if (!utf16::is_high_surrogate (seq[0]))
+          return error_code::unassigned;
+        if (seq.size () < 2)
+          return error_code::truncated;
+        return utf16::is_low_surrogate (seq[1]) ? error_code::unassigned : error_code::surrogate;
+      }
+    else
+      return diagnose_code_point (seq[0]);
+  }
+
+// The same for any range, looking at no more than its first four units.
+template <typename CharT, std::ranges::input_range R>
+  constexpr error_code
+  diagnose_front (R &&seq) noexcept
+  {
+    std::array<CharT, 4> units;
+    auto const last = std::ranges::copy (seq | std::views::take (units.size ()), units.begin ()).out;
+    return diagnose_front (std::span<CharT const> (units.begin (), last));
+  }
+
+// The offset of the first character of seq that is not valid in D, which
+// the caller knows to exist. Contiguous input is counted in bulk up to the
+// block the error is in, so only that block is walked.
+template <typename D>
+  constexpr std::size_t
+  first_invalid_offset (std::span<typename D::char_type const> const seq) noexcept
+  {
+    std::size_t offset = 0, mblen = 0;
+
+    if constexpr (requires { { D::count_contiguous (seq) } -> std::same_as<prefix_count>; })
+      if !consteval
+        {
+          offset = D::count_contiguous (seq).units;
+        }
+
+    for (; offset != seq.size (); offset += mblen)
+      {
+        mblen = D::front_mblen (seq.subspan (offset));
+        if (0 == mblen)
+          break;
+      }
+
+    return offset;
+  }
+
 export template <typename T>
   class checked<T, checked_policy::nothing>
   {
@@ -774,22 +1785,16 @@ export template <typename T>
       static constexpr std::expected<void, encoding_error>
       code_point_on (char32_t const code_point, std::span<char_type, Extent> const dest)
       {
-        if (auto const is_valid = checked<utf32, checked_policy::nothing>::is_valid_char (
-                std::views::single (code_point) ))
+        if (auto const unit_size = code_unit_size (code_point))
           {
-            if (auto const unit_size = code_unit_size (code_point))
-              {
-                if (std::ranges::size (dest) < unit_size.value ())
-                  return std::unexpected (encoding_error ());
-              }
-            else
-              return std::unexpected (unit_size.error ());
-
-            T::code_point_on (code_point, dest);
-            return std::expected<void, encoding_error> ();
+            if (std::ranges::size (dest) < unit_size.value ())
+              return std::unexpected (encoding_error ());
           }
         else
-          return std::unexpected (is_valid.error ());
+          return std::unexpected (unit_size.error ());
+
+        T::code_point_on (code_point, dest);
+        return std::expected<void, encoding_error> ();
       }
 
     template <std::ranges::input_range R>
@@ -847,20 +1852,217 @@ export template <typename T>
       static constexpr std::expected<R, encoding_error>
       code_point_to (char32_t const code_point)
       {
-        if (auto const is_valid = checked<utf32, checked_policy::nothing>::is_valid_char (
-                std::views::single (code_point) ))
+        if (auto const unit_size = code_unit_size (code_point))
           return T::template code_point_to<R> (code_point);
+        else
+          return std::unexpected (unit_size.error ());
+      }
+
+    static constexpr auto
+    encode (char32_t const code_point)
+    requires requires { T::encode (code_point); }
+    {
+      using result_type = std::expected<decltype (T::encode (code_point)), encoding_error>;
+
+      if (auto const unit_size = code_unit_size (code_point))
+        return result_type (T::encode (code_point));
+      else
+        return result_type (std::unexpect, unit_size.error ());
+    }
+  };
+
+// checked_policy::error_code reports an error_code, and
+// checked_policy::structured a char_error that also tells where. Valid
+// input costs the same as with checked_policy::nothing; only on failure is
+// the error located and looked into.
+export template <typename T, checked_policy Policy>
+requires (checked_policy::error_code == Policy || checked_policy::structured == Policy)
+  class checked<T, Policy>
+  {
+  public:
+    using char_type = typename T::char_type;
+    using decoding_error = std::conditional_t<checked_policy::structured == Policy, char_error, error_code>;
+    using encoding_error = decoding_error;
+
+  private:
+    static constexpr std::unexpected<decoding_error>
+    failure (error_code const code, std::size_t const offset = 0) noexcept
+    {
+      if constexpr (checked_policy::structured == Policy)
+        return std::unexpected (char_error { code, offset });
+      else
+        return std::unexpected (code);
+    }
+
+    // Byte-ordered databases are diagnosed in the native byte order.
+    template <std::ranges::input_range R>
+      static constexpr error_code
+      diagnose (R &&seq) noexcept
+      {
+        if constexpr (requires { T::to_native (char_type {}); })
+          return diagnose_front<char_type> (seq | std::views::transform ([] (char_type const unit)
+                                                                         {
+                                                                           return T::to_native (unit);
+                                                                         }));
+        else
+          return diagnose_front<char_type> (seq);
+      }
+
+  public:
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+      static constexpr std::expected<std::size_t, decoding_error>
+      front_mblen (R &&seq)
+      {
+        if (std::ranges::empty (seq))
+          return failure (error_code::truncated);
+
+        if (auto const mblen = T::front_mblen (seq);
+            0 != mblen)
+          return std::expected<std::size_t, decoding_error> (mblen);
+        else
+          return failure (diagnose (seq));
+      }
+
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+      static constexpr std::expected<char32_t, decoding_error>
+      to_code_point (R &&seq)
+      {
+        if (auto const is_valid = is_valid_char (seq))
+          return std::expected<char32_t, decoding_error> (T::to_code_point (seq));
         else
           return std::unexpected (is_valid.error ());
       }
+
+    static constexpr std::expected<std::size_t, encoding_error>
+    code_unit_size (char32_t const code_point)
+    {
+      if (auto const size = T::code_unit_size (code_point); size != 0)
+        return std::expected<std::size_t, encoding_error> (size);
+      else
+        return failure (diagnose_code_point (code_point));
+    }
+
+    template <std::size_t Extent = std::dynamic_extent>
+      static constexpr std::expected<void, encoding_error>
+      code_point_on (char32_t const code_point, std::span<char_type, Extent> const dest)
+      {
+        if (auto const unit_size = code_unit_size (code_point))
+          {
+            if (std::ranges::size (dest) < unit_size.value ())
+              return failure (error_code::insufficient_space);
+          }
+        else
+          return std::unexpected (unit_size.error ());
+
+        T::code_point_on (code_point, dest);
+        return std::expected<void, encoding_error> ();
+      }
+
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+      static constexpr std::expected<std::size_t, decoding_error>
+      char_size (R &&seq)
+      {
+        if (std::ranges::empty (seq))
+          return failure (error_code::truncated);
+
+        return std::expected<std::size_t, decoding_error> (T::char_size (seq));
+      }
+
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+      static constexpr std::expected<void, decoding_error>
+      is_valid_char (R &&seq)
+      {
+        if (auto const mblen = front_mblen (seq); !mblen)
+          return std::unexpected (mblen.error ());
+        else if (std::ranges::distance (seq) != static_cast<std::ranges::range_difference_t<R>> (*mblen))
+          return failure (error_code::excess_units);
+
+        return std::expected<void, decoding_error> ();
+      }
+
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+      static constexpr std::expected<void, decoding_error>
+      starts_with_valid_char (R &&seq)
+      {
+        if (auto const mblen = front_mblen (seq); !mblen)
+          return std::unexpected (mblen.error ());
+
+        return std::expected<void, decoding_error> ();
+      }
+
+    template <std::ranges::input_range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+      static constexpr std::expected<void, decoding_error>
+      validate_char_sequence (R &&seq)
+      {
+        if (std::ranges::empty (seq))
+          return failure (error_code::truncated);
+
+        if constexpr (contiguous_sized_range<R>)
+          {
+            auto const units = std::span<char_type const> (std::ranges::data (seq), std::ranges::size (seq));
+            if (T::validate_char_sequence (units))
+              return std::expected<void, decoding_error> ();
+
+            auto const offset = first_invalid_offset<T> (units);
+            return failure (diagnose (units.subspan (offset)), offset);
+          }
+        else
+          {
+            auto const sentinel = std::ranges::cend (seq);
+            auto cursor = std::ranges::cbegin (seq);
+            std::size_t offset = 0;
+
+            while (sentinel != cursor)
+              {
+                auto const rest = std::ranges::subrange (cursor, sentinel);
+                auto const mblen = T::front_mblen (rest);
+                if (0 == mblen)
+                  return failure (diagnose (rest), offset);
+
+                std::ranges::advance (cursor, mblen);
+                offset += mblen;
+              }
+
+            return std::expected<void, decoding_error> ();
+          }
+      }
+
+    template <std::ranges::range R>
+    requires std::same_as<char_type, std::remove_cvref_t<std::ranges::range_value_t<R>>>
+      static constexpr std::expected<R, encoding_error>
+      code_point_to (char32_t const code_point)
+      {
+        if (auto const unit_size = code_unit_size (code_point))
+          return T::template code_point_to<R> (code_point);
+        else
+          return std::unexpected (unit_size.error ());
+      }
+
+    static constexpr auto
+    encode (char32_t const code_point)
+    requires requires { T::encode (code_point); }
+    {
+      using result_type = std::expected<decltype (T::encode (code_point)), encoding_error>;
+
+      if (auto const unit_size = code_unit_size (code_point))
+        return result_type (T::encode (code_point));
+      else
+        return result_type (std::unexpect, unit_size.error ());
+    }
   };
 
 // TODO: implement simple wrapper class template for existing databases
 //       based on the "checked_database_of" philosophy. including:
 //       [x] no extra information
-//       [ ] simple error code
+//       [x] simple error code
 //       [ ] formatted string with the specific error reason
-//       [ ] structured information (possibly error code + specific formatted reason in string + position, etc)
+//       [x] structured information (possibly error code + specific formatted reason in string + position, etc)
 
 // TODO: tried_database_of concept; unified char_db exceptions
 
@@ -0,0 +1,76 @@
+export module vspefs.char_db : dispatch;
+
+import std;
+
+// Instruction set tiers the bulk kernels are built for. Every tier is
+// compiled into the library, and the best one the running CPU supports is
+// picked once on first use.
+namespace char_db {
+
+export enum class isa_tier : std::uint8_t
+{
+  generic,
+  sse2,
+  sse4_2,
+  avx2,
+  avx512bw,
+};
+
+// The best tier the running CPU supports.
+export isa_tier detected_isa_tier () noexcept;
+
+// The tier the bulk kernels currently run at.
+export isa_tier active_isa_tier () noexcept;
+
+// Makes the bulk kernels run at the given tier, or at the detected one if
+// the CPU does not support it, and returns the tier in effect. Meant for
+// testing and benchmarking; passing detected_isa_tier () restores the
+// default.
+export isa_tier force_isa_tier (isa_tier) noexcept;
+
+isa_tier
+detected_isa_tier () noexcept
+{
+  static isa_tier const tier = []
+    {
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+      __builtin_cpu_init ();
+
+      bool const sse2 = __builtin_cpu_supports ("sse2");
+      bool const sse4_2 = sse2 && __builtin_cpu_supports ("sse4.2") && __builtin_cpu_supports ("popcnt");
+      bool const avx2 = sse4_2 && __builtin_cpu_supports ("avx2")
+                        && __builtin_cpu_supports ("bmi") && __builtin_cpu_supports ("bmi2");
+      bool const avx512bw = avx2 && __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512bw");
+
+      if (avx512bw)
+        return isa_tier::avx512bw;
+      if (avx2)
+        return isa_tier::avx2;
+      if (sse4_2)
+        return isa_tier::sse4_2;
+      if (sse2)
+        return isa_tier::sse2;
+#endif
+      return isa_tier::generic;
+    } ();
+
+  return tier;
+}
+
+std::atomic<isa_tier> &
+active_isa_tier_state () noexcept
+{
+  static std::atomic<isa_tier> tier { detected_isa_tier () };
+  return tier;
+}
+
+isa_tier
+active_isa_tier () noexcept
+{
+  return active_isa_tier_state ().load (std::memory_order_relaxed);
+}
+
+// force_isa_tier () is defined in :simd along with the kernels it
+// switches.
+
+} // namespace char_db
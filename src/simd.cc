@@ -0,0 +1,595 @@
+module;
+#include <climits>
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>
+#endif
+
+export module vspefs.char_db : simd;
+
+import : dispatch;
+import : ucd;
+import std;
+
+// Bulk kernels over contiguous code units. Nothing here is usable in
+// constant evaluation; callers are expected to guard with `if !consteval`
+// and keep their scalar algorithm as the reference behavior. The kernels
+// themselves live in <char_db/simd_kernels.inc> and are built once per
+// instruction set tier; the functions at the bottom of this file forward
+// to the tier that is active.
+namespace char_db::simd {
+
+enum class utf8_structure : std::uint8_t
+{
+  ill_formed,
+  ascii,
+  well_formed,
+};
+
+enum class utf16_structure : std::uint8_t
+{
+  ill_formed,
+  bmp,
+  well_formed,
+};
+
+// class swar_word
+//
+// Portable word-at-a-time fallback used when no vector extension is
+// available, and for the tails shorter than a vector block.
+
+struct swar_word
+{
+  using uintword_t = std::uint64_t;
+  static constexpr std::size_t size = sizeof (uintword_t);
+  static constexpr uintword_t high_bits = 0x8080808080808080U;
+
+  static uintword_t
+  load (char8_t const *p) noexcept
+  {
+    uintword_t word;
+    std::memcpy (&word, p, size);
+    return word;
+  }
+};
+
+// Transcoding helpers
+//
+// Every transcoding kernel converts input that is known to be well-formed
+// (and for UTF-32, made of scalar values only) into an output with room
+// for the longest possible result. Each returns the number of units written.
+// Whatever the vector paths do not cover goes one character at a time
+// through the helpers right below, which every tier shares.
+
+std::size_t
+decode_utf8_one (char8_t const *const in, char32_t &code_point) noexcept
+{
+  char8_t const lead = in[0];
+
+  if (lead < 0x80)
+    {
+      code_point = lead;
+      return 1;
+    }
+
+  if (lead < 0xE0)
+    {
+      code_point = (lead & 0x1FU) << 6 | (in[1] & 0x3FU);
+      return 2;
+    }
+
+  if (lead < 0xF0)
+    {
+      code_point = (lead & 0x0FU) << 12 | (in[1] & 0x3FU) << 6 | (in[2] & 0x3FU);
+      return 3;
+    }
+
+  code_point = (lead & 0x07U) << 18 | (in[1] & 0x3FU) << 12 | (in[2] & 0x3FU) << 6 | (in[3] & 0x3FU);
+  return 4;
+}
+
+std::size_t
+decode_utf16_one (char16_t const *const in, char32_t &code_point) noexcept
+{
+  code_point = in[0];
+  if (code_point < 0xD800U || 0xDC00U <= code_point)
+    return 1;
+
+  code_point = ((code_point - 0xD800U) << 10 | (in[1] - 0xDC00U)) + 0x10000U;
+  return 2;
+}
+
+std::size_t
+encode_one (char32_t const code_point, char8_t *const out) noexcept
+{
+  if (code_point < 0x80)
+    {
+      out[0] = static_cast<char8_t> (code_point);
+      return 1;
+    }
+
+  if (code_point < 0x800)
+    {
+      out[0] = static_cast<char8_t> (0xC0 | code_point >> 6);
+      out[1] = static_cast<char8_t> (0x80 | (code_point & 0x3F));
+      return 2;
+    }
+
+  if (code_point < 0x10000)
+    {
+      out[0] = static_cast<char8_t> (0xE0 | code_point >> 12);
+      out[1] = static_cast<char8_t> (0x80 | (code_point >> 6 & 0x3F));
+      out[2] = static_cast<char8_t> (0x80 | (code_point & 0x3F));
+      return 3;
+    }
+
+  out[0] = static_cast<char8_t> (0xF0 | code_point >> 18);
+  out[1] = static_cast<char8_t> (0x80 | (code_point >> 12 & 0x3F));
+  out[2] = static_cast<char8_t> (0x80 | (code_point >> 6 & 0x3F));
+  out[3] = static_cast<char8_t> (0x80 | (code_point & 0x3F));
+  return 4;
+}
+
+std::size_t
+encode_one (char32_t const code_point, char16_t *const out) noexcept
+{
+  if (code_point < 0x10000)
+    {
+      out[0] = static_cast<char16_t> (code_point);
+      return 1;
+    }
+
+  out[0] = static_cast<char16_t> (0xD800U + ((code_point - 0x10000U) >> 10));
+  out[1] = static_cast<char16_t> (0xDC00U + (code_point & 0x3FFU));
+  return 2;
+}
+
+std::size_t
+encode_one (char32_t const code_point, char32_t *const out) noexcept
+{
+  out[0] = code_point;
+  return 1;
+}
+
+
+// Tables for utf8_to_utf16 and utf8_to_utf32, see the kernels.
+
+struct utf8_decode_step
+{
+  std::uint8_t shuffle;
+  std::uint8_t consumed;
+};
+
+// 0 to 63: six characters of 1 or 2 bytes; bit k tells the length of the
+// k-th. 64 to 144: four characters of 1 to 3 bytes, base-3 digits.
+inline constexpr auto utf8_decode_shuffles = []
+  {
+    std::array<std::array<std::uint8_t, 16>, 64 + 81> shuffles;
+
+    for (std::size_t index = 0; index < shuffles.size (); ++index)
+      {
+        auto &shuffle = shuffles[index];
+        shuffle.fill (0x80);
+
+        bool const narrow = index < 64;
+        std::size_t const lanes = narrow ? 6 : 4, lane_size = narrow ? 2 : 4;
+        std::size_t digits = narrow ? index : index - 64, offset = 0;
+
+        for (std::size_t lane = 0; lane < lanes; ++lane)
+          {
+            std::size_t const mblen = 1 + digits % (narrow ? 2 : 3);
+            digits /= narrow ? 2 : 3;
+
+            // The last byte goes to the least significant position.
+            for (std::size_t i = 0; i < mblen; ++i)
+              shuffle[lane * lane_size + i] = static_cast<std::uint8_t> (offset + mblen - 1 - i);
+            offset += mblen;
+          }
+      }
+
+    return shuffles;
+  } ();
+
+// Indexed by the 12-bit mask of the bytes ending a character.
+inline constexpr auto utf8_decode_steps = []
+  {
+    std::array<utf8_decode_step, 1 << 12> steps {};
+
+    for (std::size_t mask = 0; mask < steps.size (); ++mask)
+      {
+        std::array<std::size_t, 12> mblens {};
+        std::size_t count = 0, start = 0;
+
+        for (std::size_t i = 0; i < 12; ++i)
+          if ((mask >> i) & 1)
+            {
+              mblens[count++] = i + 1 - start;
+              start = i + 1;
+            }
+
+        auto const fits = [&] (std::size_t const chars, std::size_t const longest)
+          {
+            return chars <= count
+                   && std::ranges::all_of (mblens.begin (), mblens.begin () + chars,
+                                           [&] (std::size_t const mblen) { return mblen <= longest; });
+          };
+
+        std::size_t index = 0, consumed = 0;
+        if (fits (6, 2))
+          for (std::size_t k = 0, weight = 1; k < 6; ++k, weight *= 2)
+            {
+              index += (mblens[k] - 1) * weight;
+              consumed += mblens[k];
+            }
+        else if (fits (4, 3))
+          {
+            index = 64;
+            for (std::size_t k = 0, weight = 1; k < 4; ++k, weight *= 3)
+              {
+                index += (mblens[k] - 1) * weight;
+                consumed += mblens[k];
+              }
+          }
+
+        steps[mask] = { static_cast<std::uint8_t> (index), static_cast<std::uint8_t> (consumed) };
+      }
+
+    return steps;
+  } ();
+
+// Tables for utf16_to_utf8 and utf32_to_utf8, see the kernels.
+
+struct utf8_encode_step
+{
+  std::array<std::uint8_t, 16> shuffle;
+  std::uint8_t length;
+};
+
+// Indexed by the lanes at least 0x80 in the low nibble and the lanes at
+// least 0x800 in the high one.
+inline constexpr auto utf8_encode_steps = []
+  {
+    std::array<utf8_encode_step, 1 << 8> steps {};
+
+    for (std::size_t index = 0; index < steps.size (); ++index)
+      {
+        auto &step = steps[index];
+        step.shuffle.fill (0x80);
+
+        for (std::size_t lane = 0; lane < 4; ++lane)
+          {
+            std::size_t const mblen = 1 + ((index >> lane) & 1) + ((index >> (lane + 4)) & 1);
+            for (std::size_t i = 0; i < mblen; ++i)
+              step.shuffle[step.length++] = static_cast<std::uint8_t> (lane * 4 + i);
+          }
+      }
+
+    return steps;
+  } ();
+
+// class kernel_table
+//
+// The kernels of one tier. simd_kernels.inc defines one of these per
+// inclusion, listing its functions in this order.
+
+struct kernel_table
+{
+  std::size_t (*ascii_prefix_length) (char8_t const *, char8_t const *) noexcept;
+  utf8_structure (*check_utf8_structure) (char8_t const *, char8_t const *) noexcept;
+  utf16_structure (*check_utf16_structure) (char16_t const *, char16_t const *) noexcept;
+  std::size_t (*scalar_value_prefix_length) (char32_t const *, char32_t const *) noexcept;
+  std::size_t (*assigned_prefix_length) (char32_t const *, char32_t const *) noexcept;
+  std::size_t (*utf8_to_utf16) (char8_t const *, char8_t const *, char16_t *) noexcept;
+  std::size_t (*utf8_to_utf32) (char8_t const *, char8_t const *, char32_t *) noexcept;
+  std::size_t (*utf16_to_utf8) (char16_t const *, char16_t const *, char8_t *) noexcept;
+  std::size_t (*utf16_to_utf32) (char16_t const *, char16_t const *, char32_t *) noexcept;
+  std::size_t (*utf32_to_utf8) (char32_t const *, char32_t const *, char8_t *) noexcept;
+  std::size_t (*utf32_to_utf16) (char32_t const *, char32_t const *, char16_t *) noexcept;
+  std::size_t (*utf8_to_utf16_length) (char8_t const *, char8_t const *) noexcept;
+  std::size_t (*utf8_to_utf32_length) (char8_t const *, char8_t const *) noexcept;
+  std::size_t (*utf16_to_utf8_length) (char16_t const *, char16_t const *) noexcept;
+  std::size_t (*utf16_to_utf32_length) (char16_t const *, char16_t const *) noexcept;
+  std::size_t (*utf32_to_utf8_length) (char32_t const *, char32_t const *) noexcept;
+  std::size_t (*utf32_to_utf16_length) (char32_t const *, char32_t const *) noexcept;
+  std::uint64_t (*utf8_char_starts) (char8_t const *) noexcept;
+  std::uint64_t (*utf16_char_starts) (char16_t const *) noexcept;
+};
+
+} // namespace char_db::simd
+
+
+// Kernels per tier
+//
+// The generic tier has the scalar paths only and is all there is off x86.
+// The others are compiled with their instruction sets enabled just for
+// their own functions, so the library as a whole still runs anywhere.
+
+#define CHAR_DB_SIMD_SSE2 0
+#define CHAR_DB_SIMD_SSE4_1 0
+#define CHAR_DB_SIMD_AVX2 0
+#define CHAR_DB_SIMD_AVX512BW 0
+namespace char_db::simd::generic {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
+#include <char_db/simd_kernels.inc>
+#pragma clang diagnostic pop
+} // namespace char_db::simd::generic
+#undef CHAR_DB_SIMD_SSE2
+#undef CHAR_DB_SIMD_SSE4_1
+#undef CHAR_DB_SIMD_AVX2
+#undef CHAR_DB_SIMD_AVX512BW
+
+#if defined (__x86_64__) || defined (__i386__)
+#define CHAR_DB_SIMD_SSE2 1
+#define CHAR_DB_SIMD_SSE4_1 0
+#define CHAR_DB_SIMD_AVX2 0
+#define CHAR_DB_SIMD_AVX512BW 0
+#if defined (__clang__)
+#pragma clang attribute push (__attribute__ ((target ("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target ("sse2")
+#endif
+namespace char_db::simd::sse2 {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
+#include <char_db/simd_kernels.inc>
+#pragma clang diagnostic pop
+} // namespace char_db::simd::sse2
+#if defined (__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#undef CHAR_DB_SIMD_SSE2
+#undef CHAR_DB_SIMD_SSE4_1
+#undef CHAR_DB_SIMD_AVX2
+#undef CHAR_DB_SIMD_AVX512BW
+
+#define CHAR_DB_SIMD_SSE2 1
+#define CHAR_DB_SIMD_SSE4_1 1
+#define CHAR_DB_SIMD_AVX2 0
+#define CHAR_DB_SIMD_AVX512BW 0
+#if defined (__clang__)
+#pragma clang attribute push (__attribute__ ((target ("sse4.2,popcnt"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target ("sse4.2,popcnt")
+#endif
+namespace char_db::simd::sse4_2 {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
+#include <char_db/simd_kernels.inc>
+#pragma clang diagnostic pop
+} // namespace char_db::simd::sse4_2
+#if defined (__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#undef CHAR_DB_SIMD_SSE2
+#undef CHAR_DB_SIMD_SSE4_1
+#undef CHAR_DB_SIMD_AVX2
+#undef CHAR_DB_SIMD_AVX512BW
+
+#define CHAR_DB_SIMD_SSE2 1
+#define CHAR_DB_SIMD_SSE4_1 1
+#define CHAR_DB_SIMD_AVX2 1
+#define CHAR_DB_SIMD_AVX512BW 0
+#if defined (__clang__)
+#pragma clang attribute push (__attribute__ ((target ("avx2,bmi,bmi2,popcnt"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target ("avx2,bmi,bmi2,popcnt")
+#endif
+namespace char_db::simd::avx2 {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
+#include <char_db/simd_kernels.inc>
+#pragma clang diagnostic pop
+} // namespace char_db::simd::avx2
+#if defined (__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#undef CHAR_DB_SIMD_SSE2
+#undef CHAR_DB_SIMD_SSE4_1
+#undef CHAR_DB_SIMD_AVX2
+#undef CHAR_DB_SIMD_AVX512BW
+
+#define CHAR_DB_SIMD_SSE2 1
+#define CHAR_DB_SIMD_SSE4_1 1
+#define CHAR_DB_SIMD_AVX2 1
+#define CHAR_DB_SIMD_AVX512BW 1
+#if defined (__clang__)
+#pragma clang attribute push (__attribute__ ((target ("avx512f,avx512bw,avx2,bmi,bmi2,popcnt"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target ("avx512f,avx512bw,avx2,bmi,bmi2,popcnt")
+#endif
+namespace char_db::simd::avx512bw {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
+#include <char_db/simd_kernels.inc>
+#pragma clang diagnostic pop
+} // namespace char_db::simd::avx512bw
+#if defined (__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#undef CHAR_DB_SIMD_SSE2
+#undef CHAR_DB_SIMD_SSE4_1
+#undef CHAR_DB_SIMD_AVX2
+#undef CHAR_DB_SIMD_AVX512BW
+#endif
+
+
+namespace char_db::simd {
+
+kernel_table const &
+kernels_of (isa_tier const tier) noexcept
+{
+  switch (tier)
+    {
+#if defined (__x86_64__) || defined (__i386__)
+    case isa_tier::avx512bw:
+      return avx512bw::kernels;
+    case isa_tier::avx2:
+      return avx2::kernels;
+    case isa_tier::sse4_2:
+      return sse4_2::kernels;
+    case isa_tier::sse2:
+      return sse2::kernels;
+#endif
+    default:
+      return generic::kernels;
+    }
+}
+
+// The kernels of the active tier, resolved on first use and replaced by
+// force_isa_tier (), so that a call through the functions below is one
+// load and an indirect call.
+constinit std::atomic<kernel_table const *> active_table = nullptr;
+
+kernel_table const &
+active_kernels () noexcept
+{
+  auto table = active_table.load (std::memory_order_relaxed);
+  if (nullptr == table) [[unlikely]]
+    {
+      auto const resolved = &kernels_of (active_isa_tier ());
+      if (active_table.compare_exchange_strong (table, resolved, std::memory_order_relaxed))
+        table = resolved;
+    }
+  return *table;
+}
+
+std::size_t
+ascii_prefix_length (char8_t const *const first, char8_t const *const last) noexcept
+{
+  return active_kernels ().ascii_prefix_length (first, last);
+}
+
+utf8_structure
+check_utf8_structure (char8_t const *const first, char8_t const *const last) noexcept
+{
+  return active_kernels ().check_utf8_structure (first, last);
+}
+
+utf16_structure
+check_utf16_structure (char16_t const *const first, char16_t const *const last) noexcept
+{
+  return active_kernels ().check_utf16_structure (first, last);
+}
+
+std::size_t
+scalar_value_prefix_length (char32_t const *const first, char32_t const *const last) noexcept
+{
+  return active_kernels ().scalar_value_prefix_length (first, last);
+}
+
+std::size_t
+assigned_prefix_length (char32_t const *const first, char32_t const *const last) noexcept
+{
+  return active_kernels ().assigned_prefix_length (first, last);
+}
+
+std::size_t
+utf8_to_utf16 (char8_t const *const first, char8_t const *const last, char16_t *const out) noexcept
+{
+  return active_kernels ().utf8_to_utf16 (first, last, out);
+}
+
+std::size_t
+utf8_to_utf32 (char8_t const *const first, char8_t const *const last, char32_t *const out) noexcept
+{
+  return active_kernels ().utf8_to_utf32 (first, last, out);
+}
+
+std::size_t
+utf16_to_utf8 (char16_t const *const first, char16_t const *const last, char8_t *const out) noexcept
+{
+  return active_kernels ().utf16_to_utf8 (first, last, out);
+}
+
+std::size_t
+utf16_to_utf32 (char16_t const *const first, char16_t const *const last, char32_t *const out) noexcept
+{
+  return active_kernels ().utf16_to_utf32 (first, last, out);
+}
+
+std::size_t
+utf32_to_utf8 (char32_t const *const first, char32_t const *const last, char8_t *const out) noexcept
+{
+  return active_kernels ().utf32_to_utf8 (first, last, out);
+}
+
+std::size_t
+utf32_to_utf16 (char32_t const *const first, char32_t const *const last, char16_t *const out) noexcept
+{
+  return active_kernels ().utf32_to_utf16 (first, last, out);
+}
+
+std::size_t
+utf8_to_utf16_length (char8_t const *const first, char8_t const *const last) noexcept
+{
+  return active_kernels ().utf8_to_utf16_length (first, last);
+}
+
+std::size_t
+utf8_to_utf32_length (char8_t const *const first, char8_t const *const last) noexcept
+{
+  return active_kernels ().utf8_to_utf32_length (first, last);
+}
+
+std::size_t
+utf16_to_utf8_length (char16_t const *const first, char16_t const *const last) noexcept
+{
+  return active_kernels ().utf16_to_utf8_length (first, last);
+}
+
+std::size_t
+utf16_to_utf32_length (char16_t const *const first, char16_t const *const last) noexcept
+{
+  return active_kernels ().utf16_to_utf32_length (first, last);
+}
+
+std::size_t
+utf32_to_utf8_length (char32_t const *const first, char32_t const *const last) noexcept
+{
+  return active_kernels ().utf32_to_utf8_length (first, last);
+}
+
+std::size_t
+utf32_to_utf16_length (char32_t const *const first, char32_t const *const last) noexcept
+{
+  return active_kernels ().utf32_to_utf16_length (first, last);
+}
+
+std::uint64_t
+utf8_char_starts (char8_t const *const first) noexcept
+{
+  return active_kernels ().utf8_char_starts (first);
+}
+
+std::uint64_t
+utf16_char_starts (char16_t const *const first) noexcept
+{
+  return active_kernels ().utf16_char_starts (first);
+}
+
+} // namespace char_db::simd
+
+namespace char_db {
+
+isa_tier
+force_isa_tier (isa_tier const tier) noexcept
+{
+  auto const supported = std::min (tier, detected_isa_tier ());
+  active_isa_tier_state ().store (supported, std::memory_order_relaxed);
+  simd::active_table.store (&simd::kernels_of (supported), std::memory_order_relaxed);
+  return supported;
+}
+
+} // namespace char_db
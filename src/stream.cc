@@ -0,0 +1,180 @@
+export module vspefs.char_db : stream;
+
+import : database;
+import : bulk;
+import std;
+
+// streaming
+//
+// Input that arrives in pieces splits characters at arbitrary points. A
+// stream transcoder converts every piece as far as its last complete
+// character with the bulk algorithms, and carries the units of a
+// character cut short at the end over to the next piece.
+namespace char_db {
+
+// The length of the character prefix seq ends with, 0 if it ends on a
+// character boundary.
+template <typename Db>
+  constexpr std::size_t
+  incomplete_suffix_length (std::span<typename Db::char_type const> const seq) noexcept
+  {
+    for (std::size_t length = 1; length < Db::max_mblen && length <= seq.size (); ++length)
+      if (is_char_prefix<Db> (seq.last (length)))
+        return length;
+
+    return 0;
+  }
+
+// feed () converts a piece of input, keeping a trailing incomplete
+// character for the next call; its result counts such units as read.
+// flush () ends the stream, failing if a character is left incomplete.
+//
+// On invalid_input, the offending character begins with the pending ()
+// units carried over from earlier pieces, followed by input[read]. On
+// output_exhausted, a carried character that did not fit stays pending
+// and is written first by the next call.
+export template <typename From, typename To>
+requires bulk_database<From> && database_of<To, typename To::char_type>
+  class stream_transcoder
+  {
+  public:
+    using from_char_type = typename From::char_type;
+    using to_char_type = typename To::char_type;
+
+    constexpr transcode_result feed (std::span<from_char_type const>, std::span<to_char_type>) noexcept;
+    constexpr transcode_result flush (std::span<to_char_type>) noexcept;
+
+    // The number of units carried over from earlier pieces.
+    constexpr std::size_t pending () const noexcept;
+
+    // Drops the units carried over.
+    constexpr void reset () noexcept;
+
+  private:
+    constexpr std::span<from_char_type const> carried () const noexcept;
+    constexpr bool emit_carried (std::span<to_char_type>, transcode_result &) noexcept;
+
+    std::array<from_char_type, From::max_mblen> carry_ {};
+    std::size_t carry_size_ = 0;
+  };
+
+// stream_decoder<Db> decodes into UTF-32 with the same rules about
+// unassigned code points as Db.
+export template <typename Db>
+  using stream_decoder = stream_transcoder<Db, utf32_counterpart<Db>>;
+
+template <typename From, typename To>
+requires bulk_database<From> && database_of<To, typename To::char_type>
+  constexpr transcode_result
+  stream_transcoder<From, To>::feed (std::span<from_char_type const> const input,
+                                     std::span<to_char_type> const output) noexcept
+  {
+    auto result = transcode_result { 0, 0, transcode_status::ok };
+
+    if (0 != carry_size_)
+      {
+        while (0 == From::front_mblen (carried ()))
+          {
+            if (input.size () == result.read)
+              return result;
+
+            carry_[carry_size_] = input[result.read];
+            auto const extended = std::span<from_char_type const> (carry_.data (), carry_size_ + 1);
+            if (0 == From::front_mblen (extended) && !is_char_prefix<From> (extended))
+              {
+                result.status = transcode_status::invalid_input;
+                return result;
+              }
+
+            ++carry_size_;
+            ++result.read;
+          }
+
+        if (!emit_carried (output, result))
+          return result;
+      }
+
+    auto const rest = input.subspan (result.read);
+    auto const tail = incomplete_suffix_length<From> (rest);
+    auto const body = transcode<From, To> (rest.first (rest.size () - tail), output.subspan (result.written));
+
+    result.read += body.read;
+    result.written += body.written;
+    result.status = body.status;
+    if (transcode_status::ok != body.status)
+      return result;
+
+    std::ranges::copy (rest.last (tail), carry_.begin ());
+    carry_size_ = tail;
+    result.read += tail;
+    return result;
+  }
+
+template <typename From, typename To>
+requires bulk_database<From> && database_of<To, typename To::char_type>
+  constexpr transcode_result
+  stream_transcoder<From, To>::flush (std::span<to_char_type> const output) noexcept
+  {
+    auto result = transcode_result { 0, 0, transcode_status::ok };
+
+    if (0 == carry_size_)
+      return result;
+
+    if (0 == From::front_mblen (carried ()))
+      result.status = transcode_status::invalid_input;
+    else
+      emit_carried (output, result);
+
+    return result;
+  }
+
+template <typename From, typename To>
+requires bulk_database<From> && database_of<To, typename To::char_type>
+  constexpr std::size_t
+  stream_transcoder<From, To>::pending () const noexcept
+  {
+    return carry_size_;
+  }
+
+template <typename From, typename To>
+requires bulk_database<From> && database_of<To, typename To::char_type>
+  constexpr void
+  stream_transcoder<From, To>::reset () noexcept
+  {
+    carry_size_ = 0;
+  }
+
+template <typename From, typename To>
+requires bulk_database<From> && database_of<To, typename To::char_type>
+  constexpr std::span<typename From::char_type const>
+  stream_transcoder<From, To>::carried () const noexcept
+  {
+    return { carry_.data (), carry_size_ };
+  }
+
+// Writes the complete character carried over, which stays pending if it
+// is not valid in To or does not fit.
+template <typename From, typename To>
+requires bulk_database<From> && database_of<To, typename To::char_type>
+  constexpr bool
+  stream_transcoder<From, To>::emit_carried (std::span<to_char_type> const output,
+                                             transcode_result &result) noexcept
+  {
+    auto const code_point = From::to_code_point (carried ());
+    auto const size = To::code_unit_size (code_point);
+
+    if (0 == size)
+      result.status = transcode_status::invalid_input;
+    else if (output.size () - result.written < size)
+      result.status = transcode_status::output_exhausted;
+    else
+      {
+        To::code_point_on (code_point, output.subspan (result.written, size));
+        result.written += size;
+        carry_size_ = 0;
+      }
+
+    return transcode_status::ok == result.status;
+  }
+
+} // namespace char_db
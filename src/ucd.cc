@@ -0,0 +1,85 @@
+export module vspefs.char_db : ucd;
+
+import std;
+
+// Tables derived from the Unicode Character Database by tools/ucd_gen.py,
+// shared by every database.
+namespace char_db::ucd {
+
+inline constexpr char32_t max_code_point = 0x10FFFFU;
+inline constexpr char32_t replacement_character = 0xFFFDU;
+
+// Code points listed in UnicodeData.txt (surrogates excluded) as a
+// two-stage bitmap: stage 1 maps each block of 256 code points to a
+// deduplicated 256-bit bitmap in stage 2.
+inline constexpr std::size_t assigned_block_shift = 8;
+inline constexpr std::size_t assigned_words_per_block = (1U << assigned_block_shift) / 64;
+
+inline constexpr auto assigned_stage1 = std::to_array<std::uint16_t> ({
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
+#include <char_db/generated/assigned_stage1.inc>
+#pragma clang diagnostic pop
+    });
+
+inline constexpr auto assigned_stage2 = std::to_array<std::uint64_t> ({
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winclude-angled-in-module-purview"
+#include <char_db/generated/assigned_stage2.inc>
+#pragma clang diagnostic pop
+    });
+
+// The assigned bits of the 64 code points sharing code_point >> 6, which
+// must be at most max_code_point.
+constexpr std::uint64_t
+assigned_word (char32_t const code_point) noexcept
+{
+  std::size_t const block = assigned_stage1[code_point >> assigned_block_shift];
+  std::size_t const word_in_block = (code_point >> 6) & (assigned_words_per_block - 1);
+  return assigned_stage2[block * assigned_words_per_block + word_in_block];
+}
+
+constexpr bool
+is_assigned (char32_t const code_point) noexcept
+{
+  if (max_code_point < code_point)
+    return false;
+
+  return (assigned_word (code_point) >> (code_point & 63)) & 1;
+}
+
+// Whether every code point in a sequence of scalar values is assigned,
+// without a branch per element so the table loads can overlap. The UTF-16
+// form takes well-formed input.
+bool
+all_assigned (std::span<char32_t const> const code_points) noexcept
+{
+  std::uint64_t assigned = 1;
+
+  for (char32_t const code_point : code_points)
+    assigned &= assigned_word (code_point) >> (code_point & 63);
+
+  return 0 != (assigned & 1);
+}
+
+bool
+all_assigned (std::span<char16_t const> const units) noexcept
+{
+  std::uint64_t assigned = 1;
+
+  for (std::size_t i = 0; i < units.size (); ++i)
+    {
+      char32_t code_point = units[i];
+      if (0xD800U <= code_point && code_point < 0xDC00U) [[unlikely]]
+        {
+          code_point = ((code_point - 0xD800U) << 10 | (units[i + 1] - 0xDC00U)) + 0x10000U;
+          ++i;
+        }
+
+      assigned &= assigned_word (code_point) >> (code_point & 63);
+    }
+
+  return 0 != (assigned & 1);
+}
+
+} // namespace char_db::ucd
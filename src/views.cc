@@ -4,6 +4,7 @@ export module vspefs.char_db : views;
 #pragma clang diagnostic ignored "-Wimport-implementation-partition-unit-in-interface-unit"
   import : utils;
   import : containers;
+  import : ucd;
 #pragma clang diagnostic pop
 
 import : database;
@@ -34,6 +35,10 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
       constexpr iterator &operator-- () requires std::ranges::bidirectional_range<V>;
       constexpr iterator operator-- (int) requires std::ranges::bidirectional_range<V>;
 
+      // The code point *this encodes, decoded along with finding its end.
+      // U+FFFD if the subrange is not a valid character.
+      constexpr char32_t code_point () const noexcept;
+
       friend constexpr bool operator== (iterator const &x, iterator const &y)
       {
         return x.current_ == y.current_;
@@ -43,11 +48,12 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
         return x.current_ == x.next_;
       }
     private:
-      constexpr iterator (decoding_view &, std::ranges::iterator_t<V>, std::ranges::iterator_t<V>);
+      constexpr iterator (decoding_view &, std::ranges::iterator_t<V>, std::ranges::iterator_t<V>, char32_t);
 
       decoding_view *parent_;
       std::ranges::iterator_t<V> current_;
       std::ranges::iterator_t<V> next_;
+      char32_t code_point_;
     };
     using char_type = std::ranges::range_value_t<V>;
   public:
@@ -59,10 +65,18 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
     constexpr iterator begin ();
     constexpr auto end ();
   private:
-    constexpr std::ranges::iterator_t<V> find_next (std::ranges::iterator_t<V>);
-    constexpr std::ranges::iterator_t<V> find_prev (std::ranges::iterator_t<V>) requires std::ranges::bidirectional_range<V>;
+    // Where a step from an iterator lands, and the code point of the
+    // character stepped over.
+    struct step
+    {
+      std::ranges::iterator_t<V> position;
+      char32_t code_point;
+    };
+
+    constexpr step find_next (std::ranges::iterator_t<V>);
+    constexpr step find_prev (std::ranges::iterator_t<V>) requires std::ranges::bidirectional_range<V>;
     V base_;
-    utils::non_propagating_cache<std::ranges::iterator_t<V>> begin_;
+    utils::non_propagating_cache<step> begin_;
   };
 
 export template <typename Db, std::ranges::forward_range V>
@@ -75,7 +89,9 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
     public:
       using value_type = std::ranges::subrange<std::ranges::iterator_t<V>>;
       using difference_type = std::ranges::range_difference_t<V>;
-      using iterator_concept = std::bidirectional_iterator_tag;
+      using iterator_concept = std::conditional_t<std::ranges::random_access_range<V>,
+                                                  std::random_access_iterator_tag,
+                                                  std::bidirectional_iterator_tag>;
       friend class decoded_view;
     public:
       iterator () = default;
@@ -86,6 +102,10 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
       constexpr iterator &operator-- ();
       constexpr iterator operator-- (int);
 
+      constexpr iterator &operator+= (difference_type) requires std::ranges::random_access_range<V>;
+      constexpr iterator &operator-= (difference_type) requires std::ranges::random_access_range<V>;
+      constexpr value_type operator[] (difference_type) const requires std::ranges::random_access_range<V>;
+
       friend constexpr bool operator== (iterator const &x, iterator const &y)
       {
         return x.rank_ == y.rank_;
@@ -94,11 +114,43 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
       {
         return x.rank_ == x.parent_->book_.count ();
       }
+      friend constexpr std::strong_ordering operator<=> (iterator const &x, iterator const &y)
+      requires std::ranges::random_access_range<V>
+      {
+        return x.rank_ <=> y.rank_;
+      }
+
+      friend constexpr iterator operator+ (iterator x, difference_type n)
+      requires std::ranges::random_access_range<V>
+      {
+        return x += n;
+      }
+      friend constexpr iterator operator+ (difference_type n, iterator x)
+      requires std::ranges::random_access_range<V>
+      {
+        return x += n;
+      }
+      friend constexpr iterator operator- (iterator x, difference_type n)
+      requires std::ranges::random_access_range<V>
+      {
+        return x -= n;
+      }
+      friend constexpr difference_type operator- (iterator const &x, iterator const &y)
+      requires std::ranges::random_access_range<V>
+      {
+        return static_cast<difference_type> (x.rank_) - static_cast<difference_type> (y.rank_);
+      }
     private:
       constexpr iterator (decoded_view &, std::size_t);
 
+      // Looks up the offsets of the character at rank_ and of the one
+      // after it.
+      constexpr void locate ();
+
       decoded_view *parent_;
       std::size_t rank_;
+      std::size_t current_;
+      std::size_t next_;
     };
     using char_type = std::ranges::range_value_t<V>;
   public:
@@ -109,6 +161,9 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
     constexpr V base () &&;
     constexpr iterator begin ();
     constexpr auto end ();
+
+    // The number of characters, known since construction.
+    constexpr std::size_t size () const noexcept;
   private:
     V base_;
     containers::succinct_bitset<std::dynamic_extent> book_;
@@ -118,10 +173,12 @@ template <typename Db, std::ranges::forward_range V>
 requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoding_view<Db, V>::iterator::iterator (decoding_view &parent,
                                                       std::ranges::iterator_t<V> current,
-                                                      std::ranges::iterator_t<V> next)
+                                                      std::ranges::iterator_t<V> next,
+                                                      char32_t const code_point)
   : parent_ (std::addressof (parent)),
     current_ (std::move (current)),
-    next_ (std::move (next))
+    next_ (std::move (next)),
+    code_point_ (code_point)
   {
   }
 
@@ -133,13 +190,23 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
     return std::ranges::subrange (current_, next_);
   }
 
+template <typename Db, std::ranges::forward_range V>
+requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
+  constexpr char32_t
+  decoding_view<Db, V>::iterator::code_point () const noexcept
+  {
+    return code_point_;
+  }
+
 template <typename Db, std::ranges::forward_range V>
 requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoding_view<Db, V>::iterator &
   decoding_view<Db, V>::iterator::operator++ ()
   {
     current_ = next_;
-    next_ = parent_->find_next (current_);
+    auto const step = parent_->find_next (current_);
+    next_ = step.position;
+    code_point_ = step.code_point;
     return *this;
   }
 
@@ -158,8 +225,10 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoding_view<Db, V>::iterator &
   decoding_view<Db, V>::iterator::operator-- () requires std::ranges::bidirectional_range<V>
   {
+    auto const step = parent_->find_prev (current_);
     next_ = current_;
-    current_ = parent_->find_prev (current_);
+    current_ = step.position;
+    code_point_ = step.code_point;
     return *this;
   }
 
@@ -201,17 +270,10 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoding_view<Db, V>::iterator
   decoding_view<Db, V>::begin ()
   {
-    std::ranges::iterator_t<V> iter;
-
-    if (begin_.has_value ())
-      iter = begin_.value ();
-    else
-      {
-        iter = find_next (std::ranges::begin (base ()));
-        begin_.emplace (iter);
-      }
+    if (!begin_.has_value ())
+      begin_.emplace (find_next (std::ranges::begin (base_)));
 
-    return iterator (*this, std::ranges::begin (base ()), iter);
+    return iterator (*this, std::ranges::begin (base_), begin_->position, begin_->code_point);
   }
 
 template <typename Db, std::ranges::forward_range V>
@@ -220,40 +282,57 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   decoding_view<Db, V>::end ()
   {
     if constexpr (std::ranges::common_range<V>)
-      return iterator (*this, std::ranges::end (base_), std::ranges::end (base_));
+      return iterator (*this, std::ranges::end (base_), std::ranges::end (base_),
+                       ucd::replacement_character);
     else
       return std::default_sentinel;
   }
 
 template <typename Db, std::ranges::forward_range V>
 requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
-  constexpr std::ranges::iterator_t<V>
+  constexpr decoding_view<Db, V>::step
   decoding_view<Db, V>::find_next (std::ranges::iterator_t<V> current)
   {
-    auto const subseq = std::ranges::subrange (current, std::ranges::end (base_));
-    if (auto const mblen = Db::front_mblen (subseq);
-        mblen > 0)
+    if (std::ranges::end (base_) == current)
+      return { std::ranges::end (base_), ucd::replacement_character };
+
+    if constexpr (std::ranges::contiguous_range<V> && std::ranges::sized_range<V>)
       {
-        auto const next = std::ranges::next (current, mblen, std::ranges::end (base_));
-        if (std::ranges::end (base_) != next)
-          return next;
+        auto const first = std::to_address (current);
+        auto const last = std::ranges::data (base_) + std::ranges::size (base_);
+        if (auto const decoded = Db::decode_front (std::span<char_type const> (first, last));
+            decoded.mblen > 0)
+          return { current + decoded.mblen, decoded.code_point };
+        return { std::ranges::end (base_), ucd::replacement_character };
       }
-    return std::ranges::end (base_);
+
+    auto const subseq = std::ranges::subrange (current, std::ranges::end (base_));
+    if (auto const decoded = Db::decode_front (subseq);
+        decoded.mblen > 0)
+      return { std::ranges::next (current, decoded.mblen, std::ranges::end (base_)), decoded.code_point };
+    return { std::ranges::end (base_), ucd::replacement_character };
   }
 
+// Stepping back resynchronizes on the units just before current, so it
+// reads no more than the longest character. Where those units are not a
+// valid character, one of them is stepped over as U+FFFD; unlike going
+// forward, which ends at the first invalid unit, going backward over
+// ill-formed input carries on past it.
 template <typename Db, std::ranges::forward_range V>
 requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
-  constexpr std::ranges::iterator_t<V>
+  constexpr decoding_view<Db, V>::step
   decoding_view<Db, V>::find_prev (std::ranges::iterator_t<V> current) requires std::ranges::bidirectional_range<V>
   {
-    for (auto const probe : std::ranges::subrange (std::make_reverse_iterator (current), std::ranges::rend (base_)))
-      {
-        auto const iter = probe.base ();
-        if (auto const subseq = std::ranges::subrange (iter, current);
-            Db::is_valid_char (subseq))
-          return iter;
-      }
-    return std::ranges::begin (base_);
+    auto const first = std::ranges::begin (base_);
+    if (first == current)
+      return { current, ucd::replacement_character };
+
+    auto const start = Db::char_start_before (first, current);
+    if (auto const decoded = Db::decode_front (std::ranges::subrange (start, current));
+        0 != decoded.mblen && std::ranges::next (start, decoded.mblen) == current)
+      return { start, decoded.code_point };
+
+    return { std::ranges::prev (current), ucd::replacement_character };
   }
 
 template <typename Db, std::ranges::forward_range V>
@@ -262,6 +341,16 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
                                                      std::size_t const rank)
   : parent_ (std::addressof (parent)), rank_ (rank)
   {
+    locate ();
+  }
+
+template <typename Db, std::ranges::forward_range V>
+requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
+  constexpr void
+  decoded_view<Db, V>::iterator::locate ()
+  {
+    current_ = parent_->book_.select (rank_);
+    next_ = parent_->book_.select (rank_ + 1);
   }
 
 template <typename Db, std::ranges::forward_range V>
@@ -269,10 +358,10 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoded_view<Db, V>::iterator::value_type
   decoded_view<Db, V>::iterator::operator* () const
   {
-    auto const this_iter = std::ranges::next (parent_->base ().begin (),
-                                              parent_->book_.select (rank_));
-    auto const next_iter = std::ranges::next (parent_->base ().begin (),
-                                              parent_->book_.select (rank_ + 1));
+    using difference = std::ranges::range_difference_t<V>;
+    auto const this_iter = std::ranges::next (std::ranges::begin (parent_->base_),
+                                              static_cast<difference> (current_));
+    auto const next_iter = std::ranges::next (this_iter, static_cast<difference> (next_ - current_));
     return std::ranges::subrange (this_iter, next_iter);
   }
 
@@ -281,8 +370,12 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoded_view<Db, V>::iterator &
   decoded_view<Db, V>::iterator::operator++ ()
   {
-    if (parent_->end () != *this)
-      ++rank_;
+    if (parent_->book_.count () != rank_)
+      {
+        ++rank_;
+        current_ = next_;
+        next_ = parent_->book_.select (rank_ + 1);
+      }
     return *this;
   }
 
@@ -301,8 +394,12 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoded_view<Db, V>::iterator &
   decoded_view<Db, V>::iterator::operator-- ()
   {
-    if (std::ranges::begin (parent_->base ()) != *this)
-      --rank_;
+    if (0 != rank_)
+      {
+        --rank_;
+        next_ = current_;
+        current_ = parent_->book_.select (rank_);
+      }
     return *this;
   }
 
@@ -316,22 +413,116 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
     return tmp;
   }
 
+template <typename Db, std::ranges::forward_range V>
+requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
+  constexpr decoded_view<Db, V>::iterator &
+  decoded_view<Db, V>::iterator::operator+= (difference_type const n)
+  requires std::ranges::random_access_range<V>
+  {
+    rank_ += n;
+    locate ();
+    return *this;
+  }
+
+template <typename Db, std::ranges::forward_range V>
+requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
+  constexpr decoded_view<Db, V>::iterator &
+  decoded_view<Db, V>::iterator::operator-= (difference_type const n)
+  requires std::ranges::random_access_range<V>
+  {
+    rank_ -= n;
+    locate ();
+    return *this;
+  }
+
+template <typename Db, std::ranges::forward_range V>
+requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
+  constexpr decoded_view<Db, V>::iterator::value_type
+  decoded_view<Db, V>::iterator::operator[] (difference_type const n) const
+  requires std::ranges::random_access_range<V>
+  {
+    return *(*this + n);
+  }
+
+// Sets the bits of words standing for the units of seq a valid character
+// starts at. Valid runs are found with the bulk counter and their
+// characters marked 64 units at a time. The counter gives up on a whole
+// block at once, so the block it stopped at is walked a character or a
+// unit at a time rather than handed back to it after every invalid unit.
+template <typename Db, typename Word>
+  void
+  mark_char_starts (std::span<typename Db::char_type const> const seq, std::span<Word> const words) noexcept
+  {
+    constexpr std::size_t block_size = 64;
+    constexpr std::size_t word_size = std::numeric_limits<Word>::digits;
+
+    for (std::size_t offset = 0; offset != seq.size (); )
+      {
+        auto const last = offset + Db::count_contiguous (seq.subspan (offset)).units;
+
+        for (auto block = offset / block_size * block_size; block < last; block += block_size)
+          {
+            std::uint64_t starts;
+            if (seq.size () - block >= block_size)
+              starts = Db::char_starts (seq.data () + block);
+            else
+              {
+                std::array<typename Db::char_type, block_size> padded {};
+                std::ranges::copy (seq.subspan (block), padded.begin ());
+                starts = Db::char_starts (padded.data ());
+              }
+
+            if (block < offset)
+              starts &= ~std::uint64_t { 0 } << (offset - block);
+            if (last - block < block_size)
+              starts &= (std::uint64_t { 1 } << (last - block)) - 1;
+
+            for (std::size_t shift = 0; shift != block_size && block + shift < seq.size (); shift += word_size)
+              words[(block + shift) / word_size] |= static_cast<Word> (starts >> shift);
+          }
+
+        offset = last;
+        for (auto const rejected_end = std::min (seq.size (), last + count_block_size); offset < rejected_end; )
+          if (auto const mblen = Db::front_mblen (seq.subspan (offset)); 0 != mblen)
+            {
+              words[offset / word_size] |= Word { 1 } << (offset % word_size);
+              offset += mblen;
+            }
+          else
+            ++offset;
+      }
+  }
+
 template <typename Db, std::ranges::forward_range V>
 requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
   constexpr decoded_view<Db, V>::decoded_view (V base)
   : base_ (std::move (base)), book_ ()
   {
-    using dynamic_bitset = std::vector<bool>;
-    dynamic_bitset book (std::ranges::size (base_), false);
+    using bitset = containers::succinct_bitset<std::dynamic_extent>;
+    auto const size = static_cast<std::size_t> (std::ranges::size (base_));
+    std::vector<bitset::word_type> words ((size + bitset::word_size - 1) / bitset::word_size, 0);
+
+    if constexpr (std::ranges::contiguous_range<V>
+                  && requires (std::span<char_type const> seq, char_type const *first) {
+                       Db::count_contiguous (seq);
+                       Db::char_starts (first);
+                     })
+      if !consteval
+        {
+          mark_char_starts<Db> (std::span<char_type const> (std::ranges::data (base_), size),
+                                std::span<bitset::word_type> (words));
+          book_ = bitset (std::move (words), size);
+          return;
+        }
 
     auto const begin = std::ranges::cbegin (base_);
     auto const end = std::ranges::cend (base_);
     std::size_t index = 0;
     for (auto iter = begin; iter != end; ++iter, ++index)
       if (Db::starts_with_valid_char (std::ranges::subrange (iter, end)))
-        book[index] = true;
+        words[index / bitset::word_size] |= bitset::word_type { 1 } << (index % bitset::word_size);
 
-    book_ = containers::succinct_bitset<std::dynamic_extent> (std::from_range, std::move (book));
+    book_ = bitset (std::move (words), size);
   }
 
 template <typename Db, std::ranges::forward_range V>
@@ -369,6 +560,14 @@ requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
       return std::default_sentinel;
   }
 
+template <typename Db, std::ranges::forward_range V>
+requires std::ranges::view<V> && database_of<Db, std::ranges::range_value_t<V>>
+  constexpr std::size_t
+  decoded_view<Db, V>::size () const noexcept
+  {
+    return book_.count ();
+  }
+
 } // namespace char_db
 
 namespace char_db::views {
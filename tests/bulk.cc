@@ -0,0 +1,363 @@
+module vspefs.char_db;
+
+import std;
+
+#include "check.inc"
+
+// Differential tests of the bulk paths. At every instruction set tier the
+// CPU supports, validating, counting and transcoding contiguous input must
+// agree exactly with the scalar walks the bulk paths stand in for, in
+// either byte order. Text is mostly valid, with ill-formed units put next
+// to the boundaries the bulk paths split their input at: vector lanes,
+// count blocks and chunks.
+namespace char_db {
+
+using namespace testing;
+
+// Units stored the other way round from the machine's, so they are
+// swapped on the way in or out.
+constexpr auto foreign_order = std::endian::big == std::endian::native ? std::endian::little : std::endian::big;
+
+template <typename CharT>
+  std::vector<CharT>
+  ill_formed_units ()
+  {
+    if constexpr (std::same_as<CharT, char8_t>)
+      return { 0x80, 0xBF, 0xC0, 0xC1, 0xE0, 0xED, 0xF0, 0xF4, 0xF5, 0xFF };
+    else if constexpr (std::same_as<CharT, char16_t>)
+      return { 0xD800, 0xDBFF, 0xDC00, 0xDFFF };
+    else
+      return { 0xD800, 0xDFFF, 0x110000, 0xFFFFFFFF };
+  }
+
+// Code points of every encoded length, unassigned ones included. Text
+// drawn from ASCII alone or mostly ASCII keeps the ASCII fast paths busy.
+char32_t
+random_code_point (std::mt19937 &rng, unsigned const profile)
+{
+  auto const draw = [&rng] (char32_t const first, char32_t const last)
+    {
+      return std::uniform_int_distribution<char32_t> (first, last) (rng);
+    };
+
+  if (0 == profile || (1 == profile && 0 != rng () % 8))
+    return draw (0, 0x7F);
+
+  switch (rng () % 4)
+    {
+    case 0:
+      return draw (0, 0x7F);
+    case 1:
+      return draw (0x80, 0x7FF);
+    case 2:
+      {
+        auto code_point = draw (0x800, 0xFFFF - 0x800);
+        return code_point < 0xD800 ? code_point : code_point + 0x800;
+      }
+    default:
+      return draw (0x10000, 0x10FFFF);
+    }
+}
+
+template <typename CharT>
+  std::vector<CharT>
+  random_text (std::mt19937 &rng, std::size_t const size, bool const ill_formed)
+  {
+    using encoder = typename utf_databases<CharT>::wellformed;
+
+    std::vector<CharT> text;
+    auto const profile = static_cast<unsigned> (rng () % 3);
+    while (text.size () < size)
+      std::ranges::copy (encoder::encode (random_code_point (rng, profile)), std::back_inserter (text));
+
+    if (ill_formed)
+      {
+        auto const units = ill_formed_units<CharT> ();
+        for (std::size_t const step : { std::size_t { 16 }, std::size_t { 64 }, count_block_size, chunk_size })
+          if (step + 2 < text.size ())
+            {
+              auto const boundary = step * std::uniform_int_distribution<std::size_t> (1, (text.size () - 2) / step) (rng);
+              text[boundary - 2 + rng () % 4] = units[rng () % units.size ()];
+            }
+      }
+
+    return text;
+  }
+
+template <typename Db>
+  void
+  check_validation (std::span<typename Db::char_type const> const text)
+  {
+    // Not contiguous, so the database walks it a character at a time.
+    std::deque<typename Db::char_type> const walked (text.begin (), text.end ());
+
+    expect (Db::validate_char_sequence (walked) == Db::validate_char_sequence (text), "validate_char_sequence");
+    expect (Db::char_size (walked) == Db::char_size (text), "char_size");
+
+    // The first invalid character of contiguous input is found by counting
+    // in bulk and then walking, and must be the one a walk alone finds.
+    using structured = checked<Db, checked_policy::structured>;
+    expect (structured::validate_char_sequence (walked) == structured::validate_char_sequence (text),
+            "checked validate_char_sequence");
+  }
+
+// Indexing characters word by word over contiguous input, and a unit at
+// a time otherwise, must find the same characters.
+template <typename Db>
+  void
+  check_decoded (std::span<typename Db::char_type const> const text)
+  {
+    std::deque<typename Db::char_type> const walked (text.begin (), text.end ());
+    auto contiguous = text | views::decoded<Db>;
+    auto indexed = walked | views::decoded<Db>;
+
+    expect (contiguous.size () == indexed.size (), "decoded_view size");
+    for (auto x = contiguous.begin (), y = indexed.begin ();
+         x != contiguous.end () && y != indexed.end (); ++x, ++y)
+      expect ((*x).begin () - text.begin () == (*y).begin () - walked.begin () && (*x).size () == (*y).size (),
+              "decoded_view element");
+  }
+
+template <typename From, typename To, bool Replace>
+  void
+  check_transcoding (std::span<typename From::char_type const> const text, std::size_t const room)
+  {
+    std::vector<typename To::char_type> bulk (room), scalar (room);
+
+    auto const result = Replace ? transcode_replacing<From, To> (text, bulk) : transcode<From, To> (text, bulk);
+    auto expected = transcode_result { 0, 0, transcode_status::ok };
+    transcode_scalar<From, To, Replace> (text, scalar, expected, text.size ());
+
+    expect (result.read == expected.read && result.written == expected.written
+            && result.status == expected.status
+            && std::ranges::equal (std::span (bulk).first (result.written),
+                                   std::span (scalar).first (expected.written)),
+            Replace ? "transcode_replacing" : "transcode");
+
+    if constexpr (!Replace)
+      {
+        auto measured = transcode_result { 0, 0, transcode_status::ok };
+        required_length_scalar<From, To> (text, measured, text.size ());
+        expect (required_length<From, To> (text) == measured.written, "required_length");
+      }
+  }
+
+template <typename From, typename... To>
+  void
+  check_database (std::span<typename From::char_type const> const text, std::mt19937 &rng)
+  {
+    check_validation<From> (text);
+    check_decoded<From> (text);
+
+    // Enough room for any text, and a random amount that usually runs out.
+    for (auto const room : { 4 * text.size (), rng () % (text.size () + 1) })
+      {
+        (check_transcoding<From, To, false> (text, room), ...);
+        (check_transcoding<From, To, true> (text, room), ...);
+      }
+  }
+
+// Feeding text in pieces, some one unit long and most cutting characters
+// in two, with little room for output at a time, must write what one
+// transcode writes and fail at the same character. flush () fails exactly
+// when the text ends in the middle of a character.
+template <typename From, typename To>
+  void
+  check_stream (std::span<typename From::char_type const> const text, std::mt19937 &rng)
+  {
+    std::vector<typename To::char_type> expected (4 * text.size () + 4);
+    auto const once = transcode<From, To> (text, expected);
+    expected.resize (once.written);
+    auto const rest = text.subspan (once.read);
+    bool const cut_short = transcode_status::invalid_input == once.status && rest.size () < From::max_mblen
+                           && is_char_prefix<From> (rest);
+
+    stream_transcoder<From, To> stream;
+    std::vector<typename To::char_type> written;
+    std::array<typename To::char_type, 64> room;
+    auto status = transcode_status::ok;
+    std::size_t consumed = 0;
+
+    while (consumed != text.size () && transcode_status::invalid_input != status)
+      {
+        std::size_t const limits[] = { 1, 8, 300, chunk_size + 100 };
+        auto piece = text.subspan (consumed, std::min<std::size_t> (1 + rng () % limits[rng () % 4],
+                                                                    text.size () - consumed));
+        do
+          {
+            auto const output = std::span (room).first (rng () % (room.size () + 1));
+            auto const result = stream.feed (piece, output);
+            written.insert (written.end (), output.begin (), output.begin () + result.written);
+            consumed += result.read;
+            piece = piece.subspan (result.read);
+            status = result.status;
+          }
+        while (transcode_status::output_exhausted == status);
+        expect (transcode_status::invalid_input == status || piece.empty (), "feed reads its piece");
+      }
+
+    if (transcode_status::ok == status)
+      {
+        auto const flushed = stream.flush (room);
+        status = flushed.status;
+        expect (0 == flushed.written, "flush writes nothing");
+        expect ((transcode_status::invalid_input == status) == cut_short, "flush fails on a cut character");
+      }
+
+    expect (written == expected, "stream output");
+    expect ((transcode_status::ok == status) == (transcode_status::ok == once.status), "stream status");
+    if (transcode_status::ok != status)
+      expect (consumed - stream.pending () == once.read, "stream error position");
+  }
+
+// Appending encoded code points to a buffer that already holds a few
+// units must add what one transcode writes, and stop at the same invalid
+// code point. Lengths around encode_tail_length and chunk_size put the
+// last whole vectors next to the end of the exactly sized output.
+template <typename Db>
+  void
+  check_encode_all (std::mt19937 &rng)
+  {
+    using char_type = typename Db::char_type;
+
+    std::vector<std::size_t> lengths;
+    for (std::size_t length = 0; length <= 40; ++length)
+      lengths.push_back (length);
+    for (auto const near : { chunk_size, chunk_size + encode_tail_length, 2 * chunk_size })
+      for (auto length = near - 3; length <= near + 3; ++length)
+        lengths.push_back (length);
+
+    for (auto const length : lengths)
+      {
+        std::vector<char32_t> input;
+        auto const profile = static_cast<unsigned> (rng () % 3);
+        while (input.size () < length)
+          if (auto const code_point = random_code_point (rng, profile); 0 != Db::code_unit_size (code_point))
+            input.push_back (code_point);
+        if (!input.empty () && 0 == rng () % 4)
+          input[rng () % input.size ()] = 0 == rng () % 2 ? 0xD800 : 0x110000;
+
+        std::vector<char_type> expected (4 * length);
+        auto const once = transcode<utf32_counterpart<Db>, Db> (input, expected);
+        expected.resize (once.written);
+
+        auto const prefix = rng () % 5;
+        std::basic_string<char_type> string (prefix, char_type { '-' });
+        std::vector<char_type> vector (prefix, char_type { '-' });
+        auto const to_string = encode_all<Db> (input, string);
+        auto const to_vector = encode_all<Db> (input, vector);
+
+        for (auto const &result : { to_string, to_vector })
+          expect (result.read == once.read && result.written == once.written && result.status == once.status,
+                  "encode_all result");
+        expect (string.size () == prefix + expected.size ()
+                && std::ranges::all_of (string.substr (0, prefix), [] (char_type const unit) { return '-' == unit; })
+                && std::ranges::equal (string.substr (prefix), expected),
+                "encode_all into a string");
+        expect (vector.size () == prefix + expected.size ()
+                && std::ranges::all_of (vector | std::views::take (prefix), [] (char_type const unit) { return '-' == unit; })
+                && std::ranges::equal (vector | std::views::drop (prefix), expected),
+                "encode_all into a vector");
+      }
+  }
+
+// Stepping back through valid text resynchronizes on the units before
+// each character, and must find the characters stepping forward finds.
+template <typename Db>
+  void
+  check_reverse (std::span<typename Db::char_type const> const text)
+  {
+    struct element
+    {
+      std::ptrdiff_t offset;
+      std::size_t size;
+      char32_t code_point;
+
+      bool operator== (element const &) const = default;
+    };
+
+    auto decoding = text | views::decoding<Db>;
+    std::vector<element> forward, backward;
+    for (auto iter = decoding.begin (); iter != decoding.end (); ++iter)
+      forward.push_back ({ (*iter).begin () - text.begin (), (*iter).size (), iter.code_point () });
+    auto reversed = decoding | std::views::reverse;
+    for (auto iter = reversed.begin (); iter != reversed.end (); ++iter)
+      backward.push_back ({ (*iter).begin () - text.begin (), (*iter).size (),
+                            std::ranges::prev (iter.base ()).code_point () });
+
+    std::ranges::reverse (backward);
+    expect (forward == backward, "decoding_view in reverse");
+  }
+
+template <typename From>
+  void
+  check_source (std::span<typename From::char_type const> const text, std::mt19937 &rng)
+  {
+    check_database<From, utf8, utf16, utf32, utf8_wellformed, utf16_wellformed, utf32_wellformed,
+                   byte_ordered<utf16, foreign_order>, byte_ordered<utf32, foreign_order>> (text, rng);
+    check_stream<From, utf8> (text, rng);
+    check_stream<From, utf16_wellformed> (text, rng);
+    check_stream<From, utf32> (text, rng);
+    check_stream<From, byte_ordered<utf16, foreign_order>> (text, rng);
+
+    // Cut inside the last character From accepts, so the stream ends short
+    // of it.
+    std::vector<char32_t> code_points (text.size ());
+    auto const valid = transcode<From, utf32_wellformed> (text, code_points).read;
+    if (0 != valid)
+      check_stream<From, utf8_wellformed> (text.first (valid - 1), rng);
+    check_reverse<From> (text.first (valid));
+  }
+
+template <typename CharT>
+  void
+  check_text (std::mt19937 &rng)
+  {
+    auto text = random_text<CharT> (rng, rng () % (3 * chunk_size), 0 != rng () % 3);
+    check_source<typename utf_databases<CharT>::checked> (text, rng);
+    check_source<typename utf_databases<CharT>::wellformed> (text, rng);
+
+    if constexpr (1 < sizeof (CharT))
+      {
+        using swapped = byte_ordered<typename utf_databases<CharT>::checked, foreign_order>;
+        for (auto &unit : text)
+          unit = swapped::to_native (unit);
+        check_source<swapped> (text, rng);
+      }
+  }
+
+} // namespace char_db
+
+extern "C++" int
+main ()
+{
+  using namespace char_db;
+
+  std::mt19937 rng (0x636462);
+  for (auto const tier : { isa_tier::generic, isa_tier::sse2, isa_tier::sse4_2, isa_tier::avx2, isa_tier::avx512bw })
+    {
+      // Tiers the CPU does not support fall back to the detected one,
+      // which is tested on its own turn.
+      if (force_isa_tier (tier) != tier)
+        continue;
+
+      for (int round = 0; round != 40; ++round)
+        {
+          context = std::format ("tier {}, round {}", std::to_underlying (tier), round);
+          check_text<char8_t> (rng);
+          check_text<char16_t> (rng);
+          check_text<char32_t> (rng);
+          if (0 == round % 4)
+            {
+              check_encode_all<utf8> (rng);
+              check_encode_all<utf16> (rng);
+              check_encode_all<utf8_wellformed> (rng);
+              check_encode_all<byte_ordered<utf16, foreign_order>> (rng);
+              check_encode_all<byte_ordered<utf32, foreign_order>> (rng);
+            }
+        }
+    }
+
+  force_isa_tier (detected_isa_tier ());
+  return report ();
+}
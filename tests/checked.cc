@@ -0,0 +1,137 @@
+module vspefs.char_db;
+
+import std;
+
+#include "check.inc"
+
+// The errors checked databases report, each where the sequence ends and
+// with more input after it, in either byte order. Contiguous input is
+// counted in bulk before the walk and other input is only walked, so both
+// are checked to report the same error at the same offset.
+namespace char_db {
+
+using namespace testing;
+
+constexpr auto foreign_order = std::endian::big == std::endian::native ? std::endian::little : std::endian::big;
+
+template <typename CharT>
+  struct error_case
+  {
+    std::vector<CharT> units;
+    char_error error;
+  };
+
+template <typename Db>
+  void
+  check_error (std::span<typename Db::char_type const> const units, char_error const error)
+  {
+    using structured = checked<Db, checked_policy::structured>;
+    using coded = checked<Db, checked_policy::error_code>;
+    std::deque<typename Db::char_type> const walked (units.begin (), units.end ());
+
+    expect (structured::validate_char_sequence (units) == std::unexpected (error), "structured, contiguous");
+    expect (structured::validate_char_sequence (walked) == std::unexpected (error), "structured, walked");
+    expect (coded::validate_char_sequence (units) == std::unexpected (error.code), "error code, contiguous");
+    expect (coded::validate_char_sequence (walked) == std::unexpected (error.code), "error code, walked");
+  }
+
+template <typename Db>
+  void
+  check_errors (std::vector<error_case<typename Db::char_type>> const &cases)
+  {
+    for (auto const &[units, error] : cases)
+      {
+        context = std::format ("{} units, {} at {}", units.size (), std::to_underlying (error.code), error.offset);
+        check_error<Db> (units, error);
+
+        if constexpr (1 < sizeof (typename Db::char_type))
+          {
+            using swapped = byte_ordered<Db, foreign_order>;
+            auto foreign = units;
+            for (auto &unit : foreign)
+              unit = swapped::to_native (unit);
+            check_error<swapped> (foreign, error);
+          }
+      }
+  }
+
+} // namespace char_db
+
+extern "C++" int
+main ()
+{
+  using namespace char_db;
+  using enum error_code;
+
+  check_errors<utf8> ({
+    { { 'a', 'b', 0xE2, 0x82 }, { truncated, 2 } },
+    { { 'a', 'b', 0xF0, 0x9F, 0x98 }, { truncated, 2 } },
+    { { 'a', 0xE0 }, { truncated, 1 } },
+    { { 'a', 0x80, 'b' }, { bad_continuation, 1 } },
+    { { 'a', 'b', 0x80 }, { bad_continuation, 2 } },
+    { { 'a', 0xC3, 'b' }, { bad_continuation, 1 } },
+    { { 'a', 0xE2, 0x82, 'b' }, { bad_continuation, 1 } },
+    { { 'a', 0xC0, 0x80, 'b' }, { overlong, 1 } },
+    { { 'a', 0xC1 }, { overlong, 1 } },
+    { { 'a', 0xE0, 0x80, 0x80, 'b' }, { overlong, 1 } },
+    { { 'a', 0xE0, 0x80 }, { overlong, 1 } },
+    { { 'a', 0xF0, 0x80 }, { overlong, 1 } },
+    { { 'a', 0xED, 0xA0, 0x80, 'b' }, { surrogate, 1 } },
+    { { 'a', 0xED, 0xA0 }, { surrogate, 1 } },
+    { { 'a', 0xCD, 0xB8, 'b' }, { unassigned, 1 } },
+    { { 'a', 0xCD, 0xB8 }, { unassigned, 1 } },
+    { { 'a', 0xF4, 0x90, 0x80, 0x80, 'b' }, { out_of_range, 1 } },
+    { { 'a', 0xF4, 0x90 }, { out_of_range, 1 } },
+    { { 'a', 0xF5, 'b' }, { out_of_range, 1 } },
+    { { 'a', 0xFF }, { out_of_range, 1 } },
+  });
+
+  check_errors<utf16> ({
+    { { 'a', 0xD800 }, { truncated, 1 } },
+    { { 'a', 0xD800, 'b' }, { surrogate, 1 } },
+    { { 'a', 0xDC00, 'b' }, { surrogate, 1 } },
+    { { 'a', 0xDC00 }, { surrogate, 1 } },
+    { { 'a', 0x0378, 'b' }, { unassigned, 1 } },
+    { { 'a', 0x0378 }, { unassigned, 1 } },
+  });
+
+  check_errors<utf32> ({
+    { { 'a', 0xD800, 'b' }, { surrogate, 1 } },
+    { { 'a', 0xDFFF }, { surrogate, 1 } },
+    { { 'a', 0x0378, 'b' }, { unassigned, 1 } },
+    { { 'a', 0x0378 }, { unassigned, 1 } },
+    { { 'a', 0x110000, 'b' }, { out_of_range, 1 } },
+    { { 'a', 0xFFFFFFFF }, { out_of_range, 1 } },
+  });
+
+  // Well-formedness alone accepts unassigned code points and reports the
+  // rest the same.
+  check_errors<utf8_wellformed> ({
+    { { 'a', 0xCD, 0xB8, 0xE0, 0x80 }, { overlong, 3 } },
+    { { 'a', 0xCD, 0xB8, 0xE2 }, { truncated, 3 } },
+  });
+  check_errors<utf16_wellformed> ({
+    { { 'a', 0x0378, 0xDC00 }, { surrogate, 2 } },
+  });
+  check_errors<utf32_wellformed> ({
+    { { 'a', 0x0378, 0x110000 }, { out_of_range, 2 } },
+  });
+
+  // The rest of the error codes come from single characters and code
+  // points rather than sequences.
+  context = "single characters";
+  using structured = checked<utf8, checked_policy::structured>;
+  expect (structured::validate_char_sequence (std::u8string_view ()) == std::unexpected (char_error { truncated, 0 }),
+          "empty sequence");
+  expect (structured::is_valid_char (std::u8string_view (u8"ab")) == std::unexpected (char_error { excess_units, 0 }),
+          "excess units");
+  std::array<char8_t, 2> room;
+  expect (structured::code_point_on (U'€', std::span (room)) == std::unexpected (char_error { insufficient_space, 0 }),
+          "insufficient space");
+  expect (structured::code_unit_size (0x110000) == std::unexpected (char_error { out_of_range, 0 }),
+          "code point out of range");
+  expect (structured::code_unit_size (0xDFFF) == std::unexpected (char_error { surrogate, 0 }),
+          "surrogate code point");
+
+  return report ();
+}
@@ -0,0 +1,209 @@
+module vspefs.char_db;
+
+import std;
+
+#include "check.inc"
+
+// Differential tests of succinct_bitset. Rank, select and at, of the
+// fixed-size and the dynamic bitset alike, must agree with a walk over
+// the same bits one at a time. Besides bitsets of every density, sparse
+// and nearly full ones are large enough that select samples lie many
+// superblocks apart.
+namespace char_db::containers {
+
+using namespace testing;
+
+// Returns size bits that are all clear, all set, random, every third one,
+// one in 4096 set or clear, or in runs, by pattern.
+std::vector<bool>
+pattern_bits (std::mt19937 &rng, std::size_t const size, unsigned const pattern)
+{
+  std::vector<bool> bits (size, 1 == pattern);
+  switch (pattern)
+    {
+    case 0:
+    case 1:
+      break;
+    case 2:
+      for (std::size_t pos = 0; pos != size; ++pos)
+        bits[pos] = 0 != rng () % 2;
+      break;
+    case 3:
+      for (std::size_t pos = 0; pos != size; ++pos)
+        bits[pos] = 0 == pos % 3;
+      break;
+    case 4:
+      for (std::size_t pos = 0; pos != size; ++pos)
+        bits[pos] = 0 == rng () % 4096;
+      break;
+    case 5:
+      for (std::size_t pos = 0; pos != size; ++pos)
+        bits[pos] = 0 != rng () % 4096;
+      break;
+    default:
+      // Runs of either value, up to a few superblocks long.
+      for (std::size_t pos = 0; pos != size;)
+        {
+          auto const value = 0 != rng () % 2;
+          auto const run = std::min<std::size_t> (1 + rng () % (1 << 14), size - pos);
+          for (auto const end = pos + run; pos != end; ++pos)
+            bits[pos] = value;
+        }
+      break;
+    }
+  return bits;
+}
+
+constexpr unsigned pattern_count = 7;
+
+template <typename Bitset>
+  void
+  check_bitset (Bitset const &bitset, std::vector<bool> const &bits)
+  {
+    auto const size = bits.size ();
+    auto const ones = static_cast<std::size_t> (std::ranges::count (bits, true));
+
+    expect (bitset.count () == ones, "count");
+
+    std::size_t seen[2] = { 0, 0 };
+    for (std::size_t pos = 0; pos != size; ++pos)
+      {
+        bool const bit = bits[pos];
+        expect (bitset.at (pos) == bit, "at");
+        expect (bitset.template rank<true> (pos) == seen[1], "rank<true>");
+        expect (bitset.template rank<false> (pos) == seen[0], "rank<false>");
+        if (bit)
+          expect (bitset.template select<true> (seen[1]) == pos, "select<true>");
+        else
+          expect (bitset.template select<false> (seen[0]) == pos, "select<false>");
+        ++seen[bit];
+      }
+
+    // Past the end, rank counts everything and select finds nothing.
+    expect (!bitset.at (size), "at past the end");
+    for (auto const pos : { size, size + 1, size + 4096 })
+      {
+        expect (bitset.template rank<true> (pos) == ones, "rank<true> past the end");
+        expect (bitset.template rank<false> (pos) == size - ones, "rank<false> past the end");
+      }
+    for (auto const k : { std::size_t { 0 }, std::size_t { 1 }, std::size_t { 1024 } })
+      {
+        expect (bitset.template select<true> (ones + k) == size, "select<true> past the end");
+        expect (bitset.template select<false> (size - ones + k) == size, "select<false> past the end");
+      }
+  }
+
+void
+check_dynamic (std::vector<bool> const &bits)
+{
+  using bitset = succinct_bitset<std::dynamic_extent>;
+
+  bitset const ranged (std::from_range, bits);
+  expect (ranged.size () == bits.size (), "size");
+  check_bitset (ranged, bits);
+
+  std::vector<bitset::word_type> words ((bits.size () + bitset::word_size - 1) / bitset::word_size);
+  for (std::size_t pos = 0; pos != bits.size (); ++pos)
+    if (bits[pos])
+      words[pos / bitset::word_size] |= bitset::word_type { 1 } << (pos % bitset::word_size);
+  check_bitset (bitset (std::move (words), bits.size ()), bits);
+}
+
+// Large enough to be kept off the stack.
+template <std::size_t N>
+  void
+  check_fixed (std::vector<bool> const &bits)
+  {
+    check_bitset (*std::make_unique<succinct_bitset<N>> (std::from_range, bits), bits);
+  }
+
+template <typename Word>
+  void
+  check_select_in_word (Word const word)
+  {
+    for (std::size_t bit = 0, k = 0; bit != std::numeric_limits<Word>::digits; ++bit)
+      if (0 != ((word >> bit) & 1))
+        expect (select_in_word (word, k++) == bit, "select_in_word");
+  }
+
+static_assert (0 == select_in_word (std::uint64_t { 1 }, 0));
+static_assert (63 == select_in_word (~std::uint64_t { 0 }, 63));
+static_assert (40 == select_in_word (std::uint64_t { 0x0000'0100'0000'8000 }, 1));
+static_assert (31 == select_in_word (std::uint32_t { 0x8000'0001 }, 1));
+
+constexpr auto constant_bitset = []
+{
+  std::array<bool, 200> bits {};
+  for (std::size_t pos = 0; pos < bits.size (); pos += 3)
+    bits[pos] = true;
+  return succinct_bitset<200> (std::from_range, bits);
+} ();
+
+static_assert (67 == constant_bitset.count ());
+static_assert (34 == constant_bitset.rank (100) && 66 == constant_bitset.rank<false> (100));
+static_assert (99 == constant_bitset.select (33) && 100 == constant_bitset.select<false> (66));
+static_assert (200 == constant_bitset.select (67));
+
+} // namespace char_db::containers
+
+extern "C++" int
+main ()
+{
+  using namespace char_db::containers;
+
+  std::mt19937 rng (0x636462);
+
+  for (int round = 0; round != 2000; ++round)
+    {
+      auto const word = static_cast<std::uint64_t> (rng ()) << 32 | rng ();
+      context = std::format ("word {:#x}", word);
+      check_select_in_word (word);
+      check_select_in_word (word & static_cast<std::uint64_t> (rng ()) & static_cast<std::uint64_t> (rng ()));
+      check_select_in_word (static_cast<std::uint32_t> (word));
+    }
+  for (std::size_t bit = 0; bit != 64; ++bit)
+    {
+      context = std::format ("bit {}", bit);
+      check_select_in_word (std::uint64_t { 1 } << bit);
+      check_select_in_word (~(std::uint64_t { 1 } << bit));
+    }
+
+  for (std::size_t const size : { 0, 1, 63, 64, 65, 4095, 4096, 4097, 64 * 4096 + 1 })
+    for (unsigned pattern = 0; pattern != pattern_count; ++pattern)
+      {
+        context = std::format ("dynamic, size {}, pattern {}", size, pattern);
+        check_dynamic (pattern_bits (rng, size, pattern));
+      }
+  for (int round = 0; round != 20; ++round)
+    {
+      auto const size = rng () % 100000;
+      auto const pattern = static_cast<unsigned> (rng () % pattern_count);
+      context = std::format ("dynamic, size {}, pattern {}", size, pattern);
+      check_dynamic (pattern_bits (rng, size, pattern));
+    }
+
+  // A set or clear bit in every 4096 puts consecutive select samples
+  // about 1024 superblocks apart.
+  for (unsigned const pattern : { 4, 5 })
+    {
+      context = std::format ("dynamic, sparse, pattern {}", pattern);
+      check_dynamic (pattern_bits (rng, std::size_t { 1 } << 24, pattern));
+    }
+
+  for (unsigned pattern = 0; pattern != pattern_count; ++pattern)
+    {
+      context = std::format ("fixed, pattern {}", pattern);
+      check_fixed<0> (pattern_bits (rng, 0, pattern));
+      check_fixed<1> (pattern_bits (rng, 1, pattern));
+      check_fixed<64> (pattern_bits (rng, 64, pattern));
+      check_fixed<4097> (pattern_bits (rng, 4097, pattern));
+      check_fixed<70000> (pattern_bits (rng, 70000, pattern));
+    }
+  for (unsigned const pattern : { 4, 5 })
+    {
+      context = std::format ("fixed, sparse, pattern {}", pattern);
+      check_fixed<std::size_t { 1 } << 23> (pattern_bits (rng, std::size_t { 1 } << 23, pattern));
+    }
+
+  return report ();
+}
@@ -19,37 +19,37 @@ def fetch_ucd_txt(output: str) -> bool:
         print(f"Error writing to file: {e}", file=sys.stderr)
     return False
 
-def in_bmp(codepoint: int) -> bool:
-    return 0x0000 <= codepoint <= 0xFFFF
-
-def byte_count_in_utf8(codepoint: int) -> int:
-    if codepoint < 0x80:
-        return 1
-    elif codepoint < 0x800:
-        return 2
-    elif codepoint < 0x10000:
-        return 3
-    else:
-        return 4
-
-def codepoints_to_ranges(codepoints: list[int]) -> list[tuple[int, int]]:
-    if not codepoints:
-        return []
-    ranges = []
-    start = codepoints[0]
-
-    for i in range(1, len(codepoints)):
-        if codepoints[i] != codepoints[i - 1] + 1:
-            end = codepoints[i - 1] + 1
-            ranges.append([start, end])
-            start = codepoints[i]
-
-    ranges.append([start, codepoints[-1] + 1])
-
-    return ranges
-
-def format_ranges(ranges: list[tuple[int, int]]) -> str:
-    return ','.join(f"{{U'\\U{start:08X}', U'\\U{end:08X}'}}" for start, end in ranges)
+MAX_CODEPOINT = 0x10FFFF
+WORD_BITS = 64
+BLOCK_BITS = 8
+
+def build_assigned_trie(codepoints: list[int]) -> tuple[list[int], list[int]]:
+    """Builds a two-stage table: stage 1 maps every block of 2**BLOCK_BITS
+    codepoints to the index of its bitmap in stage 2, where identical bitmaps
+    are stored once."""
+    bitmap = [0] * ((MAX_CODEPOINT + 1) // WORD_BITS)
+    for cp in codepoints:
+        bitmap[cp // WORD_BITS] |= 1 << (cp % WORD_BITS)
+
+    words_per_block = (1 << BLOCK_BITS) // WORD_BITS
+    stage1: list[int] = []
+    stage2: list[int] = []
+    block_indices: dict[tuple[int, ...], int] = {}
+
+    for start in range(0, len(bitmap), words_per_block):
+        block = tuple(bitmap[start:start + words_per_block])
+        if block not in block_indices:
+            block_indices[block] = len(block_indices)
+            stage2.extend(block)
+        stage1.append(block_indices[block])
+
+    if len(block_indices) > 0xFFFF:
+        raise ValueError("too many distinct blocks for a 16-bit stage 1 table")
+
+    return stage1, stage2
+
+def format_integers(values: list[int], digits: int) -> str:
+    return ','.join(f"0x{value:0{digits}X}U" for value in values)
 
 def main():
     ucd_path = os.path.join(sys.argv[1], "UnicodeData.txt")
@@ -57,10 +57,7 @@ def main():
         if not fetch_ucd_txt(ucd_path):
             return
 
-    bmp_codepoints: list[int] = []
-    non_bmp_codepoints: list[int] = []
-    utf8_codepoints: list[list[int]] = [[], [], [], []]
-    just_codepoints: list[int] = []
+    assigned_codepoints: list[int] = []
 
     range_start_codepoint: int | None = None
 
@@ -100,47 +97,19 @@ def main():
                 # Filter out surrogate codepoints (U+D800 to U+DFFF)
                 if 0xD800 <= cp <= 0xDFFF:
                     continue
-                
-                # Add to appropriate lists
-                if in_bmp(cp):
-                    bmp_codepoints.append(cp)
-                else:
-                    non_bmp_codepoints.append(cp)
-                
-                # Add to UTF-8 byte count lists (ensure cp is valid, non-surrogate)
-                if 0 <= cp <= 0x10FFFF: 
-                    utf8_idx = byte_count_in_utf8(cp) - 1
-                    utf8_codepoints[utf8_idx].append(cp)
-                
-                just_codepoints.append(cp)
-
-    # Sort all collected codepoint lists before generating ranges
-    bmp_codepoints.sort()
-    non_bmp_codepoints.sort()
-    for i in range(len(utf8_codepoints)):
-        utf8_codepoints[i].sort()
-    just_codepoints.sort()
-
-    bmp_ranges: list[tuple[int, int]] = codepoints_to_ranges(bmp_codepoints)
-    non_bmp_ranges: list[tuple[int, int]] = codepoints_to_ranges(non_bmp_codepoints)
-    utf8_ranges: list[list[tuple[int, int]]] = [
-        codepoints_to_ranges(cps_list) for cps_list in utf8_codepoints
-    ]
-    just_ranges: list[tuple[int, int]] = codepoints_to_ranges(just_codepoints)
+                if 0 <= cp <= MAX_CODEPOINT:
+                    assigned_codepoints.append(cp)
+
+    stage1, stage2 = build_assigned_trie(assigned_codepoints)
 
     # we needed multiple output directories for meson. now only cmake is
     # supported but i guess it's whatever.
     for output_dir in sys.argv[2:]:
         os.makedirs(output_dir, exist_ok=True)
-        with open(os.path.join(output_dir, "bmp_ranges.inc"), "w") as f:
-            f.write(format_ranges(bmp_ranges))
-        with open(os.path.join(output_dir, "non_bmp_ranges.inc"), "w") as f:
-            f.write(format_ranges(non_bmp_ranges))
-        for i, ranges in enumerate(utf8_ranges):
-            with open(os.path.join(output_dir, f"utf8_ranges_{i + 1}.inc"), "w") as f:
-                f.write(format_ranges(utf8_ranges[i]))
-        with open(os.path.join(output_dir, "just_ranges.inc"), "w") as f:
-            f.write(format_ranges(just_ranges))
+        with open(os.path.join(output_dir, "assigned_stage1.inc"), "w") as f:
+            f.write(format_integers(stage1, 4))
+        with open(os.path.join(output_dir, "assigned_stage2.inc"), "w") as f:
+            f.write(format_integers(stage2, 16))
 
 
 if __name__ == "__main__":